@@ -0,0 +1,111 @@
+/*
+ * CompletedEventDispatcher.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "CompletedEventDispatcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <initializer_list>
+#include <thread>
+
+#include "../options/Logging.h"
+
+namespace na62 {
+
+bool CompletedEventDispatcher::active_ = false;
+CompletedEventDispatcher::Stage CompletedEventDispatcher::l0Stage_;
+CompletedEventDispatcher::Stage CompletedEventDispatcher::l1Stage_;
+
+/*
+ * Maximum number of events moved from the queue at once. Larger requests are served by several batches
+ */
+static const uint_fast32_t MaxBatchSize = 256;
+
+static inline uint64_t now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void CompletedEventDispatcher::initialize(uint queueCapacity) {
+	for (Stage* stage : { &l0Stage_, &l1Stage_ }) {
+		delete stage->queue;
+		stage->queue = new BoundedMPMCQueue<Entry>(queueCapacity);
+		stage->sleepingWorkers = 0;
+	}
+	resetStatistics();
+	active_ = true;
+	LOG_INFO("Dispatching completed events via queues of " << l0Stage_.queue->size() << " events");
+}
+
+void CompletedEventDispatcher::resetStatistics() {
+	for (Stage* stage : { &l0Stage_, &l1Stage_ }) {
+		stage->queueDepth.reset();
+		stage->residenceTime.reset();
+		stage->batchSize.reset();
+		stage->queueFullStalls = 0;
+	}
+}
+
+void CompletedEventDispatcher::push(Stage& stage, Event* event) {
+	const Entry entry = { event, now() };
+	if (!stage.queue->push(entry)) {
+		/*
+		 * Never drop a complete event: wait for the workers
+		 */
+		stage.queueFullStalls.fetch_add(1, std::memory_order_relaxed);
+		while (!stage.queue->push(entry)) {
+			std::this_thread::yield();
+		}
+	}
+
+	/*
+	 * Pairs with the fence in pop(): either the worker sees the event or we see the sleeping worker
+	 */
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (stage.sleepingWorkers.load(std::memory_order_relaxed) != 0) {
+		std::lock_guard<std::mutex> lock(stage.mutex);
+		stage.eventsAvailable.notify_one();
+	}
+}
+
+uint_fast32_t CompletedEventDispatcher::pop(Stage& stage, Event** events,
+		const uint_fast32_t maxEvents, const uint timeoutMicros) {
+	const uint_fast32_t queueDepth = stage.queue->getCurrentLength();
+
+	Entry entries[MaxBatchSize];
+	uint_fast32_t numberOfEvents = stage.queue->popBatch(entries,
+			std::min(maxEvents, MaxBatchSize));
+
+	if (numberOfEvents == 0) {
+		if (timeoutMicros == 0) {
+			return 0;
+		}
+		std::unique_lock<std::mutex> lock(stage.mutex);
+		stage.sleepingWorkers.fetch_add(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		numberOfEvents = stage.queue->popBatch(entries, std::min(maxEvents, MaxBatchSize));
+		if (numberOfEvents == 0) {
+			stage.eventsAvailable.wait_for(lock, std::chrono::microseconds(timeoutMicros));
+			numberOfEvents = stage.queue->popBatch(entries, std::min(maxEvents, MaxBatchSize));
+		}
+		stage.sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+		if (numberOfEvents == 0) {
+			return 0;
+		}
+	}
+
+	const uint64_t popTime = now();
+	for (uint_fast32_t i = 0; i != numberOfEvents; i++) {
+		events[i] = entries[i].event;
+		stage.residenceTime.record(
+				popTime > entries[i].pushTime ? popTime - entries[i].pushTime : 0);
+	}
+	stage.queueDepth.record(queueDepth);
+	stage.batchSize.record(numberOfEvents);
+	return numberOfEvents;
+}
+
+} /* namespace na62 */
@@ -0,0 +1,160 @@
+/*
+ * CompletedEventDispatcher.h
+ *
+ * Hands events completed by the event building over to the trigger workers. If the dispatcher is active
+ * Event::addL0Fragment and Event::addL1Fragment push every event they complete into the L0 or L1 queue.
+ * The workers pull the events in batches to amortize the synchronization and wakeup costs.
+ *
+ * The queue depth at every dequeue and the time every event spent in the queue are recorded in histograms.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#pragma once
+#ifndef COMPLETEDEVENTDISPATCHER_H_
+#define COMPLETEDEVENTDISPATCHER_H_
+
+#include <sys/types.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#include "../utils/BoundedMPMCQueue.h"
+#include "../utils/LogLinearHistogram.h"
+
+namespace na62 {
+
+class Event;
+
+class CompletedEventDispatcher {
+public:
+	/**
+	 * Activates the dispatcher with queues of <queueCapacity> events. Use the size of the EventPool to make sure
+	 * the queues can never run full
+	 */
+	static void initialize(uint queueCapacity);
+
+	static inline bool isActive() {
+		return active_;
+	}
+
+	/*
+	 * Called by the event building as soon as all L0 fragments of <event> have been received
+	 */
+	static inline void pushL0CompletedEvent(Event* event) {
+		push(l0Stage_, event);
+	}
+
+	/*
+	 * Called by the event building as soon as all L1 fragments of <event> have been received
+	 */
+	static inline void pushL1CompletedEvent(Event* event) {
+		push(l1Stage_, event);
+	}
+
+	/**
+	 * Writes up to <maxEvents> events with all L0 fragments to <events> and returns their number. If no event is
+	 * available the calling thread waits up to <timeoutMicros> for new events
+	 */
+	static inline uint_fast32_t popL0CompletedEvents(Event** events, const uint_fast32_t maxEvents,
+			const uint timeoutMicros = 0) {
+		return pop(l0Stage_, events, maxEvents, timeoutMicros);
+	}
+
+	/**
+	 * Same as popL0CompletedEvents for events with all L1 fragments
+	 */
+	static inline uint_fast32_t popL1CompletedEvents(Event** events, const uint_fast32_t maxEvents,
+			const uint timeoutMicros = 0) {
+		return pop(l1Stage_, events, maxEvents, timeoutMicros);
+	}
+
+	static inline uint_fast32_t getL0QueueLength() {
+		return active_ ? l0Stage_.queue->getCurrentLength() : 0;
+	}
+
+	static inline uint_fast32_t getL1QueueLength() {
+		return active_ ? l1Stage_.queue->getCurrentLength() : 0;
+	}
+
+	/*
+	 * Number of events in the queue before every successful pop
+	 */
+	static inline const LogLinearHistogram& getL0QueueDepthHistogram() {
+		return l0Stage_.queueDepth;
+	}
+
+	static inline const LogLinearHistogram& getL1QueueDepthHistogram() {
+		return l1Stage_.queueDepth;
+	}
+
+	/*
+	 * Time between push and pop of every event in nanoseconds
+	 */
+	static inline const LogLinearHistogram& getL0ResidenceTimeHistogram() {
+		return l0Stage_.residenceTime;
+	}
+
+	static inline const LogLinearHistogram& getL1ResidenceTimeHistogram() {
+		return l1Stage_.residenceTime;
+	}
+
+	/*
+	 * Number of events returned by every successful pop
+	 */
+	static inline const LogLinearHistogram& getL0BatchSizeHistogram() {
+		return l0Stage_.batchSize;
+	}
+
+	static inline const LogLinearHistogram& getL1BatchSizeHistogram() {
+		return l1Stage_.batchSize;
+	}
+
+	/*
+	 * Number of times a receiver thread had to wait as the queue was full
+	 */
+	static inline uint64_t getL0QueueFullStalls() {
+		return l0Stage_.queueFullStalls.load(std::memory_order_relaxed);
+	}
+
+	static inline uint64_t getL1QueueFullStalls() {
+		return l1Stage_.queueFullStalls.load(std::memory_order_relaxed);
+	}
+
+	static void resetStatistics();
+
+private:
+	struct Entry {
+		Event* event;
+		uint64_t pushTime; // steady clock in nanoseconds
+	};
+
+	struct Stage {
+		BoundedMPMCQueue<Entry>* queue;
+
+		LogLinearHistogram queueDepth;
+		LogLinearHistogram residenceTime;
+		LogLinearHistogram batchSize;
+		std::atomic<uint64_t> queueFullStalls;
+
+		/*
+		 * Only used if a worker waits for an empty queue
+		 */
+		std::atomic<uint> sleepingWorkers;
+		std::mutex mutex;
+		std::condition_variable eventsAvailable;
+	};
+
+	static void push(Stage& stage, Event* event);
+	static uint_fast32_t pop(Stage& stage, Event** events, const uint_fast32_t maxEvents,
+			const uint timeoutMicros);
+
+	static bool active_;
+	static Stage l0Stage_;
+	static Stage l1Stage_;
+};
+
+} /* namespace na62 */
+
+#endif /* COMPLETEDEVENTDISPATCHER_H_ */
@@ -7,12 +7,18 @@
 
 #include "Event.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
 #include <netinet/in.h>
 #include <sys/types.h>
 #include <cstdbool>
+#include <cstdlib>
 #include <functional>
+#include <new>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -27,7 +33,9 @@
 #include "../structs/DataContainer.h"
 #include "../structs/L0TPHeader.h"
 #include "../utils/DataDumper.h"
+#include "CompletedEventDispatcher.h"
 #include "EventPool.h"
+#include "EventTimeoutHandler.h"
 #include "UnfinishedEventsCollector.h"
 
 namespace na62 {
@@ -37,132 +45,423 @@ std::atomic<uint64_t>* Event::MissingEventsBySourceNum_;
 std::atomic<uint64_t>* Event::MissingL1EventsBySourceNum_;
 std::atomic<uint64_t> Event::nonRequestsL1FramesReceived_;
 bool Event::printCompletedSourceIDs_ = false;
-
-Event::Event(uint_fast32_t eventNumber) :
-		eventNumber_(eventNumber), numberOfL0Fragments_(0), numberOfMEPFragments_(
-				0), burstID_(0), triggerTypeWord_(0), triggerFlags_(0), timestamp_(
-				0), finetime_(0), SOBtimestamp_(0), processingID_(0), requestZeroSuppressedCreamData_(
-		false), nonZSuppressedDataRequestedNum(0), L1Processed_(false), L2Accepted_(
-		false), unfinished_(false), lastEventOfBurst_(
-		false)
+bool Event::useContiguousStorage_ = false;
 #ifdef MEASURE_TIME
-				, l0BuildingTime_(0), l1ProcessingTime_(0), l1BuildingTime_(0), l2ProcessingTime_(
-				0)
+Event::TimingMode Event::timingMode_ = Event::TIMING_FULL;
+double Event::ticksPerMicrosecond_ = 1000.; // steady_clock ticks are nanoseconds
 #endif
-{
+size_t Event::contiguousStorageSize_ = 0;
+size_t Event::l0SubeventTableOffset_ = 0;
+size_t Event::l1SubeventTableOffset_ = 0;
+std::vector<size_t> Event::l0SubeventOffsets_;
+std::vector<size_t> Event::l1SubeventOffsets_;
+
+static inline size_t alignOffset(const size_t offset, const size_t alignment) {
+	return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+Event::Event(uint_fast32_t eventNumber, uint_fast32_t poolIndex) :
+		eventNumber_(eventNumber), poolIndex_(poolIndex), L0Subevents(nullptr), L1Subevents(nullptr), layout_(
+				SourceIDManager::getLayout()), lifecycle_(
+				makeLifecycle(0, PHASE_FREE, 0)), numberOfMEPFragments_(0), unfinished_(false), lastEventOfBurst_(
+				false), triggerTypeWord_(0), triggerFlags_(0), timestamp_(0), finetime_(
+				0), SOBtimestamp_(0), processingID_(0), requestZeroSuppressedCreamData_(
+				false), nonZSuppressedDataRequestedNum(0), L1Processed_(false), L2Accepted_(
+				false), nonSuppressedLkrFragments_(nullptr), pins_(0), pinnedBurstID_(0)
 #ifdef MEASURE_TIME
-	firstEventPartAddedTime_.stop(); //We'll start the first time addL0Event is called
+				, firstEventPartAddedTicks_(0), l0BuildingTicks_(0), l1ProcessingTicks_(0), l1BuildingTicks_(
+				0), l2ProcessingTicks_(0)
 #endif
+{
+	layout_->acquire();
+
+	if (useContiguousStorage_) {
+		/*
+		 * operator new has allocated contiguousStorageSize_ bytes for this event
+		 */
+		char* storage = reinterpret_cast<char*>(this);
+
+		L0Subevents = reinterpret_cast<l0::Subevent**>(storage + l0SubeventTableOffset_);
+		for (int i = layout_->numberOfL0Sources - 1; i >= 0; i--) {
+			char* subevent = storage + l0SubeventOffsets_[i];
+			const size_t bitmapOffset = alignOffset(sizeof(l0::Subevent)
+					+ layout_->l0PacketsBySourceNum[i] * sizeof(l0::MEPFragment*),
+					alignof(std::atomic<uint64_t>));
+			L0Subevents[i] = new (subevent) l0::Subevent(
+					layout_->l0PacketsBySourceNum[i], *layout_, i,
+					reinterpret_cast<l0::MEPFragment**>(subevent + sizeof(l0::Subevent)),
+					reinterpret_cast<std::atomic<uint64_t>*>(subevent + bitmapOffset));
+		}
+
+		L1Subevents = reinterpret_cast<l1::Subevent**>(storage + l1SubeventTableOffset_);
+		for (int i = layout_->numberOfL1Sources - 1; i >= 0; i--) {
+			char* subevent = storage + l1SubeventOffsets_[i];
+			const size_t bitmapOffset = alignOffset(sizeof(l1::Subevent)
+					+ layout_->l1PacketsBySourceNum[i] * sizeof(l1::MEPFragment*),
+					alignof(std::atomic<uint64_t>));
+			L1Subevents[i] = new (subevent) l1::Subevent(
+					layout_->l1PacketsBySourceNum[i], *layout_, i,
+					reinterpret_cast<l1::MEPFragment**>(subevent + sizeof(l1::Subevent)),
+					reinterpret_cast<std::atomic<uint64_t>*>(subevent + bitmapOffset));
+		}
+		return;
+	}
+
 	/*
 	 * Initialize subevents at the existing sourceIDs as position
 	 */
-	L0Subevents = new l0::Subevent*[SourceIDManager::NUMBER_OF_L0_DATA_SOURCES];
-	for (int i = SourceIDManager::NUMBER_OF_L0_DATA_SOURCES - 1; i >= 0; i--) {
+	L0Subevents = new l0::Subevent*[layout_->numberOfL0Sources];
+	for (int i = layout_->numberOfL0Sources - 1; i >= 0; i--) {
 		/*
 		 * Initialize subevents[sourceID] with new Subevent(Number of expected Events)
 		 */
-		L0Subevents[i] = new l0::Subevent(SourceIDManager::getExpectedPacksBySourceNum(i), SourceIDManager::sourceNumToID(i));
+		L0Subevents[i] = new l0::Subevent(layout_->l0PacketsBySourceNum[i], *layout_, i);
 	}
 
-	L1Subevents = new l1::Subevent*[SourceIDManager::NUMBER_OF_L1_DATA_SOURCES];
-	for (int i = SourceIDManager::NUMBER_OF_L1_DATA_SOURCES - 1; i >= 0; i--) {
+	L1Subevents = new l1::Subevent*[layout_->numberOfL1Sources];
+	for (int i = layout_->numberOfL1Sources - 1; i >= 0; i--) {
 		/*
 		 * Initialize subevents[sourceID] with new Subevent(Number of expected Events)
 		 */
-		L1Subevents[i] = new l1::Subevent(SourceIDManager::getExpectedL1PacksBySourceNum(i), SourceIDManager::l1SourceNumToID(i));
+		L1Subevents[i] = new l1::Subevent(layout_->l1PacketsBySourceNum[i], *layout_, i);
 	}
 }
 
 Event::~Event() {
-	LOG_INFO("Destructor of Event "<< (int) this->getEventNumber());
+	/*
+	 * Called for millions of events at once by EventPool::destroy(): don't log anything here
+	 */
+	NonZSuppressedLkrFragmentTable* table = nonSuppressedLkrFragments_.exchange(nullptr);
+	if (table != nullptr) {
+		NonZSuppressedLkrFragmentTable::release(table);
+	}
+
+	if (useContiguousStorage_) {
+		/*
+		 * The Subevents and their tables are part of the storage of this event
+		 */
+		for (uint_fast8_t i = 0; i != layout_->numberOfL0Sources; i++) {
+			L0Subevents[i]->~Subevent();
+		}
+		for (uint_fast8_t i = 0; i != layout_->numberOfL1Sources; i++) {
+			L1Subevents[i]->~Subevent();
+		}
+	} else {
+		for (uint_fast8_t i = 0; i != layout_->numberOfL0Sources; i++) {
+			delete L0Subevents[i];
+		}
+		delete[] L0Subevents;
+		for (uint_fast8_t i = 0; i != layout_->numberOfL1Sources; i++) {
+			delete L1Subevents[i];
+		}
+		delete[] L1Subevents;
+	}
+	layout_->release();
+}
+
+void Event::reassignSourceIDs() {
+	moveToLayout(SourceIDManager::getLayout());
+}
+
+void Event::moveToLayout(const SourceLayout* layout) {
+	layout->acquire();
+	layout_->release();
+	layout_ = layout;
+
+	for (uint_fast8_t i = 0; i != layout_->numberOfL0Sources; i++) {
+		L0Subevents[i]->setLayout(*layout_);
+	}
+	for (uint_fast8_t i = 0; i != layout_->numberOfL1Sources; i++) {
+		L1Subevents[i]->setLayout(*layout_);
+	}
+}
+
+bool Event::moveToCurrentLayout() {
+	uint64_t lifecycle = lifecycle_.load(std::memory_order_seq_cst);
+	for (;;) {
+		const LifecyclePhase phase = phaseOf(lifecycle);
+		if (phase == PHASE_ACTIVE) {
+			/*
+			 * Moved by finishDestruction
+			 */
+			return false;
+		}
+		if (phase == PHASE_DESTROYING) {
+			waitForDestruction();
+			lifecycle = lifecycle_.load(std::memory_order_seq_cst);
+		} else if (lifecycle_.compare_exchange_weak(lifecycle, withPhase(lifecycle, PHASE_DESTROYING),
+				std::memory_order_seq_cst)) {
+			break;
+		}
+	}
+
+	/*
+	 * Fragment adders wait for DESTROYING to end
+	 */
+	const SourceLayout* currentLayout = SourceIDManager::getLayout();
+	if (layout_ != currentLayout) {
+		moveToLayout(currentLayout);
+	}
+	lifecycle_.store(makeLifecycle(0, PHASE_FREE, 0), std::memory_order_release);
+	return true;
+}
 
+void* Event::operator new(size_t size) {
+	void* ptr;
+	if (useContiguousStorage_) {
+		size = std::max(size, contiguousStorageSize_);
+	}
+	if (posix_memalign(&ptr, alignof(Event), size) != 0) {
+		throw std::bad_alloc();
+	}
+	return ptr;
 }
 
-void Event::initialize(bool printCompletedSourceIDs) {
+void Event::operator delete(void* ptr) {
+	free(ptr);
+}
+
+void Event::initialize(bool printCompletedSourceIDs, bool useContiguousStorage) {
 
 	Event::printCompletedSourceIDs_ = printCompletedSourceIDs;
-	Event::MissingEventsBySourceNum_ = new std::atomic<uint64_t>[SourceIDManager::NUMBER_OF_L0_DATA_SOURCES] ;
-	Event::MissingL1EventsBySourceNum_ = new std::atomic<uint64_t>[SourceIDManager::NUMBER_OF_L1_DATA_SOURCES];
 
-	for (size_t i=0; i!= SourceIDManager::NUMBER_OF_L0_DATA_SOURCES; ++i)
+	/*
+	 * Events of the previous source layout may still update the counters after a switch (see
+	 * EventPool::switchSourceLayout): allocate them once for every possible sourceNum
+	 */
+	if (MissingEventsBySourceNum_ == nullptr) {
+		Event::MissingEventsBySourceNum_ = new std::atomic<uint64_t>[256];
+		Event::MissingL1EventsBySourceNum_ = new std::atomic<uint64_t>[256];
+	}
+	for (size_t i = 0; i != 256; ++i) {
 		MissingEventsBySourceNum_[i] = 0;
-	for (size_t i=0; i!= SourceIDManager::NUMBER_OF_L1_DATA_SOURCES; ++i)
 		MissingL1EventsBySourceNum_[i] = 0;
+	}
+
+	/*
+	 * Every LKr CREAM may send non zero suppressed data once per event
+	 */
+	const uint maxNonZSuppressedLkrFragments =
+			SourceIDManager::checkL1SourceID(SOURCE_ID_LKr) ?
+					SourceIDManager::getExpectedL1PacksBySourceID(SOURCE_ID_LKr) : 512;
+	NonZSuppressedLkrFragmentTable::initialize(maxNonZSuppressedLkrFragments, 64);
+
+	useContiguousStorage_ = useContiguousStorage;
+	if (!useContiguousStorage_) {
+		return;
+	}
+
+	size_t offset = sizeof(Event);
+	l0SubeventTableOffset_ = offset;
+	offset += SourceIDManager::NUMBER_OF_L0_DATA_SOURCES * sizeof(l0::Subevent*);
+	l1SubeventTableOffset_ = offset;
+	offset += SourceIDManager::NUMBER_OF_L1_DATA_SOURCES * sizeof(l1::Subevent*);
+
+	/*
+	 * Every Subevent is followed by its fragment table so that the fragment counter and the first
+	 * fragment pointers share a cache line. The bitmap of received sourceSubIDs comes right after the table
+	 */
+	l0SubeventOffsets_.resize(SourceIDManager::NUMBER_OF_L0_DATA_SOURCES);
+	for (size_t i = 0; i != SourceIDManager::NUMBER_OF_L0_DATA_SOURCES; ++i) {
+		offset = alignOffset(offset, alignof(l0::Subevent));
+		l0SubeventOffsets_[i] = offset;
+		offset += sizeof(l0::Subevent)
+				+ SourceIDManager::getExpectedPacksBySourceNum(i) * sizeof(l0::MEPFragment*);
+		offset = alignOffset(offset, alignof(std::atomic<uint64_t>));
+		offset += l0::Subevent::getNumberOfBitmapWords(SourceIDManager::getExpectedPacksBySourceNum(i))
+				* sizeof(std::atomic<uint64_t>);
+	}
+	l1SubeventOffsets_.resize(SourceIDManager::NUMBER_OF_L1_DATA_SOURCES);
+	for (size_t i = 0; i != SourceIDManager::NUMBER_OF_L1_DATA_SOURCES; ++i) {
+		offset = alignOffset(offset, alignof(l1::Subevent));
+		l1SubeventOffsets_[i] = offset;
+		offset += sizeof(l1::Subevent)
+				+ SourceIDManager::getExpectedL1PacksBySourceNum(i) * sizeof(l1::MEPFragment*);
+		offset = alignOffset(offset, alignof(std::atomic<uint64_t>));
+		offset += l1::Subevent::getNumberOfBitmapWords(SourceIDManager::getExpectedL1PacksBySourceNum(i))
+				* sizeof(std::atomic<uint64_t>);
+	}
+	contiguousStorageSize_ = alignOffset(offset, alignof(Event));
+
+	LOG_INFO("Using contiguous storage of " << contiguousStorageSize_ << " B per event");
 }
 
+#ifdef MEASURE_TIME
+/*
+ * CPUID.80000007H:EDX[8]: the TSC runs at a constant rate in all ACPI P-, C- and T-states
+ */
+static bool hasInvariantTSC() {
+#if defined(__x86_64__) || defined(__i386__)
+	unsigned int eax, ebx, ecx, edx;
+	if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) == 0 || eax < 0x80000007) {
+		return false;
+	}
+	__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+	return (edx & (1 << 8)) != 0;
+#else
+	return false;
+#endif
+}
+
+void Event::setTimingMode(TimingMode mode) {
+	if (mode == TIMING_TSC && !hasInvariantTSC()) {
+		LOG_WARNING("The CPU has no invariant TSC: Using the system clock for the event latency measurements");
+		mode = TIMING_FULL;
+	}
+
+	switch (mode) {
+	case TIMING_TSC:
+		ticksPerMicrosecond_ = Stopwatch::GetCPUFrequency() / 1E6;
+		LOG_INFO("Measuring event latencies with the TSC at " << ticksPerMicrosecond_ << " ticks per microsecond");
+		break;
+	case TIMING_FULL:
+		ticksPerMicrosecond_ = 1000.;
+		LOG_INFO("Measuring event latencies with the system clock");
+		break;
+	case TIMING_OFF:
+		LOG_INFO("Event latency measurements are switched off");
+		break;
+	}
+	timingMode_ = mode;
+}
+#endif
+
 /**
  * Process data coming from the TEL boards
  */
-bool Event::addL0Fragment(l0::MEPFragment* fragment, uint_fast32_t burstID) {
+bool Event::beginAddingL0Fragment(const uint_fast32_t burstID) {
+	uint64_t lifecycle = lifecycle_.load(std::memory_order_acquire);
+	for (;;) {
+		const LifecyclePhase phase = phaseOf(lifecycle);
+		if (phase == PHASE_FREE) {
+			if (lifecycle_.compare_exchange_weak(lifecycle,
+					makeLifecycle(burstID, PHASE_ACTIVE, 0) + AdderUnit, std::memory_order_acq_rel)) {
+				EventPool::changeEventState(poolIndex_.load(std::memory_order_relaxed), EventState::FREE,
+						EventState::BUILDING_L0);
 #ifdef MEASURE_TIME
-	if (firstEventPartAddedTime_.is_stopped()) {
-		firstEventPartAddedTime_.start();
-	}
+				if (timingMode_ != TIMING_OFF) {
+					firstEventPartAddedTicks_ = getTimingTicks();
+				}
 #endif
-	unfinished_ = true;
-	if (numberOfL0Fragments_ == 0) {
-		lastEventOfBurst_ = fragment->isLastEventOfBurst();
-		setBurstID(burstID);
-		} else {
-		if (!lastEventOfBurst_) lastEventOfBurst_ = fragment->isLastEventOfBurst(); // work around STRAWs bug
-		if (burstID > getBurstID()) {
-			if (unfinishedEventMutex_.try_lock()) {
-				LOG_ERROR("Identified non cleared event " << (uint) getEventNumber() << " from previous burst!");
-				EventPool::freeEvent(this);
-				unfinishedEventMutex_.unlock();
-			} else {
-				/*
-				 * If we didn't get the lock: wait for the other thread to free the event
-				 */
-				tbb::spin_mutex::scoped_lock my_lock(unfinishedEventMutex_);
+				if (EventTimeoutHandler::isActive()) {
+					EventTimeoutHandler::registerEvent(poolIndex_.load(std::memory_order_relaxed));
+				}
+				return true;
 			}
+		} else if (phase == PHASE_DESTROYING) {
+			waitForDestruction();
+			lifecycle = lifecycle_.load(std::memory_order_acquire);
+		} else if (burstID > burstIDOf(lifecycle)) {
 			/*
-			 * Add the event after this or another thread has destroyed this event
+			 * Only the thread winning the transition to DESTROYING frees the event. All others wait and
+			 * add their fragments afterwards
 			 */
-				return addL0Fragment(fragment, burstID);
-		}
-		else if (burstID < getBurstID()) {
-			LOG_ERROR("Received fragment from a previous burst for event " << (uint) getEventNumber());
-			delete fragment;
+			if (tryBeginDestruction()) {
+				LOG_ERROR("Identified non cleared event " << (uint) getEventNumber() << " from previous burst!");
+				finishDestruction();
+			} else {
+				// Destroyed by another thread or by the last unpin()
+				std::this_thread::yield();
+			}
+			lifecycle = lifecycle_.load(std::memory_order_acquire);
+		} else if (burstID < burstIDOf(lifecycle)) {
 			return false;
+		} else if (lifecycle_.compare_exchange_weak(lifecycle, lifecycle + AdderUnit,
+				std::memory_order_acq_rel)) {
+			return true;
 		}
 	}
+}
+
+bool Event::addL0Fragment(l0::MEPFragment* fragment, uint_fast32_t burstID) {
+	if (!beginAddingL0Fragment(burstID)) {
+		LOG_ERROR("Received fragment from a previous burst for event " << (uint) getEventNumber());
+		fragment->release();
+		return false;
+	}
 
-	l0::Subevent* subevent = L0Subevents[fragment->getSourceIDNum()];
+	/*
+	 * The event can't be destroyed before this thread has left as adder
+	 */
+	unfinished_ = true;
+
+	/*
+	 * The subevents are laid out by the layout of this event, which may differ from the current one
+	 */
+	if (!layout_->l0Descriptors[fragment->getSourceID()].valid) {
+		LOG_ERROR("type = BadEv : Fragment from sourceID 0x" << std::hex << ((int) fragment->getSourceID())
+				<< " which is not part of the source layout of event " << std::dec << (int)(this->getEventNumber()));
+		leaveAdding();
+		fragment->release();
+		return false;
+	}
+
+	/*
+	 * Any fragment may mark the last event of the burst: work around STRAWs bug
+	 */
+	if (fragment->isLastEventOfBurst()) {
+		lastEventOfBurst_ = true;
+	}
+
+	l0::Subevent* subevent = L0Subevents[SourceIDManager::sourceIDToNum(*layout_, fragment->getSourceID())];
 
 	if (!subevent->addFragment(fragment)) {
 		/*
-		 * Already received enough packets from that sourceID! Eliminate fragment
+		 * Already received a packet from that sourceSubID or it is not expected! Eliminate fragment
 		 */
 #ifdef USE_ERS
 		ers::error(DuplicateFragment(ERS_HERE, SourceIDManager::sourceIdToDetectorName(fragment->getSourceID()), fragment->getSourceSubID(), this->getEventNumber()));
 #else
-		LOG_ERROR( "type = BadEv : Already received all fragments from sourceID 0x"
+		LOG_ERROR( "type = BadEv : Duplicate or unexpected fragment from sourceID 0x"
 				<< std::hex << ((int) fragment->getSourceID()) << " sourceSubID 0x" << ((int) fragment->getSourceSubID())
 				<< " for event " << std::dec << (int)(this->getEventNumber()));
 #endif
-		delete fragment;
+		leaveAdding();
+		fragment->release();
 		return false;
 	}
 
-	uint currentValue = numberOfL0Fragments_.fetch_add(1,
-			std::memory_order_release) + 1;
+	/*
+	 * Count the fragment and leave as adder at once
+	 */
+	const uint64_t newLifecycle = lifecycle_.fetch_add(1 - AdderUnit, std::memory_order_acq_rel)
+			+ 1 - AdderUnit;
+	uint currentValue = numberOfL0FragmentsOf(newLifecycle);
+
+	/*
+	 * The event may have been expired by the EventTimeoutHandler right before adding the last fragment
+	 */
+	bool result = currentValue == layout_->expectedL0PacketsPerEvent
+			&& phaseOf(newLifecycle) == PHASE_ACTIVE;
+
+	if (result) {
+		EventPool::setEventState(poolIndex_.load(std::memory_order_relaxed), EventState::WAITING_L1);
+	}
 
 #ifdef MEASURE_TIME
-	bool result = currentValue == SourceIDManager::NUMBER_OF_EXPECTED_L0_PACKETS_PER_EVENT;
-	if (currentValue
-			== SourceIDManager::NUMBER_OF_EXPECTED_L0_PACKETS_PER_EVENT) {
-		l0BuildingTime_ = firstEventPartAddedTime_.elapsed().wall / 1E3;
-		if (currentValue
-				> SourceIDManager::NUMBER_OF_EXPECTED_L0_PACKETS_PER_EVENT)
-			LOG_ERROR( "Too many L0 Packets:" << currentValue << "/" << SourceIDManager::NUMBER_OF_EXPECTED_L0_PACKETS_PER_EVENT);
-		}
+	if (result && timingMode_ != TIMING_OFF) {
+		l0BuildingTicks_ = getTicksSinceFirstEventPart();
+		LatencyStatistics::record(LATENCY_L0_BUILDING, l0BuildingTicks_);
+	}
+#endif
+
+	/*
+	 * The event may be processed by a trigger worker as soon as it has been pushed
+	 */
+	if (result && CompletedEventDispatcher::isActive()) {
+		CompletedEventDispatcher::pushL0CompletedEvent(this);
+	}
 	return result;
+}
 
-#else
-	return currentValue
-	== SourceIDManager::NUMBER_OF_EXPECTED_L0_PACKETS_PER_EVENT;
-#endif
+bool Event::beginAddingL1Fragment() {
+	uint64_t lifecycle = lifecycle_.load(std::memory_order_acquire);
+	while (phaseOf(lifecycle) == PHASE_ACTIVE) {
+		if (lifecycle_.compare_exchange_weak(lifecycle, lifecycle + AdderUnit, std::memory_order_acq_rel)) {
+			return true;
+		}
+	}
+	return false;
 }
 
 bool Event::storeNonZSuppressedLkrFragemnt(l1::MEPFragment* fragment) {
@@ -173,14 +472,34 @@ bool Event::storeNonZSuppressedLkrFragemnt(l1::MEPFragment* fragment) {
 	const uint_fast16_t crateCREAMID = fragment->getSourceSubID();
 
 	/*
-	 * We were waiting for non zero suppressed data
+	 * We were waiting for non zero suppressed data: the first fragment attaches a table to this event
 	 */
-	auto lb = nonSuppressedLkrFragmentsByCrateCREAMID.lower_bound(crateCREAMID);
+	NonZSuppressedLkrFragmentTable* table = nonSuppressedLkrFragments_.load(std::memory_order_acquire);
+	if (table == nullptr) {
+		NonZSuppressedLkrFragmentTable* newTable = NonZSuppressedLkrFragmentTable::acquire();
+		if (nonSuppressedLkrFragments_.compare_exchange_strong(table, newTable, std::memory_order_acq_rel)) {
+			table = newTable;
+		} else {
+			// Another thread was faster: table now points to its table
+			NonZSuppressedLkrFragmentTable::release(newTable);
+		}
+	}
+
+	uint_fast16_t numberOfFragments = 0;
+	const NonZSuppressedLkrFragmentTable::InsertResult insertResult = table->insert(crateCREAMID, fragment,
+			numberOfFragments);
+	/*
+	 * The table is given back to the pool when the event is destroyed: leave as adder only after inserting
+	 */
+	leaveAdding();
 
-	if (lb != nonSuppressedLkrFragmentsByCrateCREAMID.end()
-			&& !(nonSuppressedLkrFragmentsByCrateCREAMID.key_comp()(
-					crateCREAMID, lb->first))) {
-		if (unfinishedEventMutex_.try_lock()) {
+	if (insertResult == NonZSuppressedLkrFragmentTable::TABLE_FULL) {
+		delete fragment;
+		return false;
+	}
+
+	if (insertResult == NonZSuppressedLkrFragmentTable::DUPLICATE) {
+		if (tryBeginDestruction()) {
 				LOG_INFO("Non zero suppressed LKr event with EventNumber "
 				<< (int) fragment->getEventNumber() << ", crate/creamID "
 				<< std::hex << (int) fragment->getSourceSubID()
@@ -188,29 +507,36 @@ bool Event::storeNonZSuppressedLkrFragemnt(l1::MEPFragment* fragment) {
 				<< " received twice! Will delete the whole event!");
 			nonRequestsL1FramesReceived_.fetch_add(1, std::memory_order_relaxed);
 
-			EventPool::freeEvent(this);
-			unfinishedEventMutex_.unlock();
+			finishDestruction();
 		}
 		delete fragment;
 		return false;
-	} else {
-		/*
-		 * Event does not yet exist -> add it to the map
-		 */
-		nonSuppressedLkrFragmentsByCrateCREAMID.insert(lb,
-				std::map<uint_fast16_t, l1::MEPFragment*>::value_type(crateCREAMID,
-						fragment));
 	}
-// TODO: this must be synchronized
-	return nonSuppressedLkrFragmentsByCrateCREAMID.size()
-			== nonZSuppressedDataRequestedNum;
+
+	/*
+	 * Only the thread inserting the last requested fragment sees the final count
+	 */
+	if (numberOfFragments != nonZSuppressedDataRequestedNum) {
+		return false;
+	}
+	if (CompletedEventDispatcher::isActive()) {
+		CompletedEventDispatcher::pushL1CompletedEvent(this);
+	}
+	return true;
 }
 
 /**
  * Process data coming from the CREAMs
  */
 bool Event::addL1Fragment(l1::MEPFragment* fragment) {
-	if (!L1Processed_) {
+	/*
+	 * The event can't be destroyed while this thread is registered as adder
+	 */
+	const bool isAdding = beginAddingL1Fragment();
+	if (!isAdding || !L1Processed_) {
+		if (isAdding) {
+			leaveAdding();
+		}
 #ifdef USE_ERS
 			ers::error(UnrequestedFragment(ERS_HERE, SourceIDManager::sourceIdToDetectorName(fragment->getSourceID()), fragment->getSourceSubID(), this->getEventNumber()));
 #else
@@ -228,42 +554,49 @@ bool Event::addL1Fragment(l1::MEPFragment* fragment) {
 	if (nonZSuppressedDataRequestedNum != 0) {
 		return storeNonZSuppressedLkrFragemnt(fragment);
 	} else {
-		l1::Subevent* subevent = L1Subevents[fragment->getSourceIDNum()];
+		if (!layout_->l1Descriptors[fragment->getSourceID()].valid) {
+			LOG_ERROR("type = BadEv : L1 fragment from sourceID 0x" << std::hex << ((int) fragment->getSourceID())
+					<< " which is not part of the source layout of event " << std::dec << (int)(this->getEventNumber()));
+			leaveAdding();
+			delete fragment;
+			return false;
+		}
+		l1::Subevent* subevent = L1Subevents[SourceIDManager::l1SourceIDToNum(*layout_, fragment->getSourceID())];
 		if (!subevent->addFragment(fragment)) {
 		// don't know what to do with this fragment....
 #ifdef USE_ERS
 			ers::error(DuplicateFragment(ERS_HERE, SourceIDManager::sourceIdToDetectorName(fragment->getSourceID()), fragment->getSourceSubID(), this->getEventNumber()));
 #else
-			LOG_ERROR( "type = BadEv : Already received all fragments from sourceID 0x"<< std::hex
+			LOG_ERROR( "type = BadEv : Duplicate or unexpected fragment from sourceID 0x"<< std::hex
                      << ((int) fragment->getSourceID()) << " sourceSubID 0x" << ((int) fragment->getSourceSubID())
                      << " for event " <<  std::dec <<(int)(this->getEventNumber()));
 #endif
+			leaveAdding();
 				delete fragment;
 			return false;
 		}
 
 
 		int numberOfMEPFragments = numberOfMEPFragments_.fetch_add(1, std::memory_order_release) + 1;
+		leaveAdding();
 
+		const bool result = numberOfMEPFragments
+				== layout_->expectedL1PacketsPerEvent;
 #ifdef MEASURE_TIME
-		if (numberOfMEPFragments == SourceIDManager::NUMBER_OF_EXPECTED_L1_PACKETS_PER_EVENT) {
-			l1BuildingTime_ = firstEventPartAddedTime_.elapsed().wall/ 1E3-(l1ProcessingTime_+l0BuildingTime_);
-//			LOG_INFO("l1BuildingTime_ " << l1BuildingTime_);
-			return true;
+		if (result && timingMode_ != TIMING_OFF) {
+			l1BuildingTicks_ = getTicksSinceFirstEventPart() - (l1ProcessingTicks_ + l0BuildingTicks_);
+			LatencyStatistics::record(LATENCY_L1_BUILDING, l1BuildingTicks_);
 		}
-		return false;
-#else
-
-		return numberOfMEPFragments
-		== SourceIDManager::NUMBER_OF_EXPECTED_L1_PACKETS_PER_EVENT;
 #endif
+		if (result && CompletedEventDispatcher::isActive()) {
+			CompletedEventDispatcher::pushL1CompletedEvent(this);
+		}
+		return result;
 	}
 }
 
 void Event::reset() {
-	numberOfL0Fragments_ = 0;
 	numberOfMEPFragments_ = 0;
-	burstID_ = 0;
 	triggerTypeWord_ = 0;
 	triggerFlags_ = 0;
 	timestamp_ = 0;
@@ -275,37 +608,159 @@ void Event::reset() {
 	unfinished_ = false;
 	lastEventOfBurst_ = false;
 	nonZSuppressedDataRequestedNum = 0;
+#ifdef MEASURE_TIME
+	l0BuildingTicks_ = 0;
+	l1ProcessingTicks_ = 0;
+	l1BuildingTicks_ = 0;
+	l2ProcessingTicks_ = 0;
+#endif
+	EventPool::setEventState(poolIndex_.load(std::memory_order_relaxed), EventState::FREE);
 }
 
 void Event::destroy() {
-	tbb::spin_mutex::scoped_lock my_lock(destroyMutex_);
+	if (!tryBeginDestruction()) {
+		/*
+		 * Another thread is destroying this event or it is pinned and will be destroyed by the last unpin()
+		 */
+		waitForDestruction();
+		return;
+	}
+	finishDestruction();
+}
+
+bool Event::pin() {
+	const uint64_t lifecycle = lifecycle_.load(std::memory_order_acquire);
+	if (phaseOf(lifecycle) == PHASE_FREE) {
+		return false;
+	}
+	pinnedBurstID_.store(burstIDOf(lifecycle), std::memory_order_relaxed);
+	pins_.fetch_add(1, std::memory_order_seq_cst);
+
+	/*
+	 * A thread that has moved the event to DESTROYING before the pin was visible destroys it anyway. Every
+	 * later one sees the pin (see deferDestructionIfPinned)
+	 */
+	uint64_t current = lifecycle_.load(std::memory_order_seq_cst);
+	while (phaseOf(current) == PHASE_DESTROYING) {
+		std::this_thread::yield();
+		current = lifecycle_.load(std::memory_order_seq_cst);
+	}
+
+	if (phaseOf(current) != PHASE_ACTIVE || burstIDOf(current) != burstIDOf(lifecycle)) {
+		/*
+		 * Freed or reused in the meantime. A destruction deferred to this pin since then belongs to the
+		 * current use of the event and is carried out by unpin()
+		 */
+		pinnedBurstID_.store(burstIDOf(current), std::memory_order_relaxed);
+		unpin();
+		return false;
+	}
+	return true;
+}
+
+void Event::unpin() {
+	uint32_t pins = pins_.fetch_sub(1, std::memory_order_acq_rel) - 1;
+	if (pins != FreeDeferredBit || !pins_.compare_exchange_strong(pins, 0, std::memory_order_acq_rel)) {
+		return;
+	}
+
+	const uint64_t lifecycle = lifecycle_.load(std::memory_order_acquire);
+	if (phaseOf(lifecycle) == PHASE_ACTIVE
+			&& burstIDOf(lifecycle) == pinnedBurstID_.load(std::memory_order_relaxed)) {
+		destroy();
+	}
+}
+
+bool Event::deferDestructionIfPinned() {
+	uint32_t pins = pins_.load(std::memory_order_seq_cst);
+	while ((pins & ~FreeDeferredBit) != 0) {
+		if (pins_.compare_exchange_weak(pins, pins | FreeDeferredBit, std::memory_order_acq_rel)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void Event::abortDestruction(const LifecyclePhase phase) {
+	uint64_t lifecycle = lifecycle_.load(std::memory_order_acquire);
+	while (!lifecycle_.compare_exchange_weak(lifecycle, withPhase(lifecycle, phase),
+			std::memory_order_acq_rel)) {
+	}
+}
+
+bool Event::tryBeginDestruction() {
+	uint64_t lifecycle = lifecycle_.load(std::memory_order_acquire);
+	do {
+		if (phaseOf(lifecycle) == PHASE_DESTROYING) {
+			return false;
+		}
+	} while (!lifecycle_.compare_exchange_weak(lifecycle, withPhase(lifecycle, PHASE_DESTROYING),
+			std::memory_order_seq_cst));
+
+	if (deferDestructionIfPinned()) {
+		abortDestruction(phaseOf(lifecycle));
+		return false;
+	}
+	return true;
+}
+
+void Event::finishDestruction() {
 	//std::cout << "Event::destroy() for "<< (int) (this->getEventNumber())<< std::endl;
 #ifdef MEASURE_TIME
-	firstEventPartAddedTime_.stop();
+	if (timingMode_ != TIMING_OFF && firstEventPartAddedTicks_ != 0) {
+		LatencyStatistics::record(LATENCY_EVENT_RESIDENCE, getTicksSinceFirstEventPart());
+	}
+	firstEventPartAddedTicks_ = 0;
 #endif
-
-	for (uint_fast8_t i = 0; i != SourceIDManager::NUMBER_OF_L0_DATA_SOURCES;
-			i++) {
-		L0Subevents[i]->destroy();
+	waitForAdders();
+
+	SourceIDManager::forEachL0SourceNum(*layout_, [this](const uint_fast8_t sourceNum) {
+		L0Subevents[sourceNum]->destroy();
+	});
+	SourceIDManager::forEachL1SourceNum(*layout_, [this](const uint_fast8_t sourceNum) {
+		L1Subevents[sourceNum]->destroy();
+	});
+
+	NonZSuppressedLkrFragmentTable* table = nonSuppressedLkrFragments_.exchange(nullptr,
+			std::memory_order_acq_rel);
+	if (table != nullptr) {
+		NonZSuppressedLkrFragmentTable::release(table);
 	}
-	for (uint_fast8_t i = 0; i != SourceIDManager::NUMBER_OF_L1_DATA_SOURCES;
-			i++) {
-		L1Subevents[i]->destroy();
+
+	reset();
+
+	/*
+	 * The pool has been switched to a layout of the same shape while this event was in use (see
+	 * EventPool::switchSourceLayout). Retired events keep their layout
+	 */
+	const SourceLayout* currentLayout = SourceIDManager::getLayout();
+	if (layout_ != currentLayout && poolIndex_.load(std::memory_order_relaxed) != UINT32_MAX
+			&& currentLayout->hasSameShape(*layout_)) {
+		moveToLayout(currentLayout);
 	}
+	lifecycle_.store(makeLifecycle(0, PHASE_FREE, 0), std::memory_order_release);
+}
 
-	for (auto& pair : nonSuppressedLkrFragmentsByCrateCREAMID) {
-		delete pair.second;
+void Event::waitForDestruction() const {
+	while (phaseOf(lifecycle_.load(std::memory_order_acquire)) == PHASE_DESTROYING) {
+		std::this_thread::yield();
 	}
-	nonSuppressedLkrFragmentsByCrateCREAMID.clear();
+}
 
-	reset();
+void Event::waitForAdders() const {
+	/*
+	 * Adders only insert one fragment: this is a short wait
+	 */
+	while (numberOfAddersOf(lifecycle_.load(std::memory_order_acquire)) != 0) {
+		std::this_thread::yield();
+	}
 }
 
 uint_fast8_t Event::readTriggerTypeWordAndFineTime() {
 	/*
 	 * Read the L0 trigger type word, trigger flags and the fine time from the L0TP data
 	 */
-	if (SourceIDManager::L0TP_ACTIVE) {
+	if (layout_->l0tpActive) {
 		l0::MEPFragment* L0TPEvent = getL0TPSubevent()->getFragment(0);
 		L0TpHeader* L0TPData = (L0TpHeader*) L0TPEvent->getPayload();
 		setFinetime(L0TPData->refFineTime);
@@ -319,36 +774,36 @@ uint_fast8_t Event::readTriggerTypeWordAndFineTime() {
 void Event::updateMissingEventsStats() {
 
 	if (!L1Processed_) {
-		for (int sourceNum = SourceIDManager::NUMBER_OF_L0_DATA_SOURCES - 1;
+		for (int sourceNum = layout_->numberOfL0Sources - 1;
 				sourceNum >= 0; sourceNum--) {
 			l0::Subevent* subevent = getL0SubeventBySourceIDNum(sourceNum);
 			if(subevent->getNumberOfFragments() != subevent->getNumberOfExpectedFragments()   ) {
 				MissingEventsBySourceNum_[sourceNum].fetch_add(1, std::memory_order_relaxed);
 #ifdef USE_ERS
 				ers::warning(MissingFragments(ERS_HERE, this->getEventNumber(), subevent->getNumberOfExpectedFragments() - subevent->getNumberOfFragments(),
-						SourceIDManager::sourceIdToDetectorName(SourceIDManager::sourceNumToID(sourceNum))));
+						SourceIDManager::sourceIdToDetectorName(SourceIDManager::sourceNumToID(*layout_, sourceNum))));
 #endif
 				//LOG_ERROR("Type = IncompleteEv : " << "Missing " << (int)(subevent->getNumberOfExpectedFragments() - subevent->getNumberOfFragments())
-				//		<< " fragments for det 0x" << std::hex << (int)(SourceIDManager::sourceNumToID(sourceNum)) << std::dec
+				//		<< " fragments for det 0x" << std::hex << (int)(SourceIDManager::sourceNumToID(*layout_, sourceNum)) << std::dec
 				//		<< " in event " << (int)(this->getEventNumber()));
 
 			}
 		}
 	}
 	else {
-		for (int sourceNum = SourceIDManager::NUMBER_OF_L1_DATA_SOURCES - 1;
+		for (int sourceNum = layout_->numberOfL1Sources - 1;
 				sourceNum >= 0; sourceNum--) {
 			l1::Subevent* subevent = getL1SubeventBySourceIDNum(sourceNum);
 			if(subevent->getNumberOfFragments() != subevent->getNumberOfExpectedFragments()   ) {
 				MissingL1EventsBySourceNum_[sourceNum].fetch_add(1,std::memory_order_relaxed);
 #ifdef USE_ERS
 				ers::warning(MissingFragments(ERS_HERE, this->getEventNumber(), subevent->getNumberOfExpectedFragments() - subevent->getNumberOfFragments(),
-						SourceIDManager::sourceIdToDetectorName(SourceIDManager::sourceNumToID(sourceNum))));
+						SourceIDManager::sourceIdToDetectorName(SourceIDManager::sourceNumToID(*layout_, sourceNum))));
 #endif
 
 
 				//LOG_ERROR("Type = IncompleteEv : Missing " << (int)(subevent->getNumberOfExpectedFragments() - subevent->getNumberOfFragments())
-				//		<< " fragments for det 0x" << std::hex << (int)(SourceIDManager::l1SourceNumToID(sourceNum)) << std::dec
+				//		<< " fragments for det 0x" << std::hex << (int)(SourceIDManager::l1SourceNumToID(*layout_, sourceNum)) << std::dec
 				//		<< " in event " << (int)(this->getEventNumber()));
 			}
 		}
@@ -356,4 +811,134 @@ void Event::updateMissingEventsStats() {
 	return;
 }
 
+void Event::updateMissingEventsStats(uint64_t* missingL0EventsBySourceNum,
+		uint64_t* missingL1EventsBySourceNum,
+		std::map<uint, std::map<uint, uint>>& receivedSubSourceIDsBySourceNum) {
+	if (!L1Processed_) {
+		for (int sourceNum = layout_->numberOfL0Sources - 1;
+				sourceNum >= 0; sourceNum--) {
+			l0::Subevent* subevent = getL0SubeventBySourceIDNum(sourceNum);
+			if (subevent->getNumberOfFragments() != subevent->getNumberOfExpectedFragments()) {
+				missingL0EventsBySourceNum[sourceNum]++;
+#ifdef USE_ERS
+				ers::warning(MissingFragments(ERS_HERE, this->getEventNumber(), subevent->getNumberOfExpectedFragments() - subevent->getNumberOfFragments(),
+						SourceIDManager::sourceIdToDetectorName(SourceIDManager::sourceNumToID(*layout_, sourceNum))));
+#endif
+				std::map<uint, uint>& receivedSubSourceIDs = receivedSubSourceIDsBySourceNum[sourceNum];
+				for (uint_fast16_t i = 0; i != subevent->getNumberOfFragments(); i++) {
+					receivedSubSourceIDs[subevent->getFragment(i)->getSourceSubID()]++;
+				}
+			}
+		}
+	} else {
+		for (int sourceNum = layout_->numberOfL1Sources - 1;
+				sourceNum >= 0; sourceNum--) {
+			l1::Subevent* subevent = getL1SubeventBySourceIDNum(sourceNum);
+			if (subevent->getNumberOfFragments() != subevent->getNumberOfExpectedFragments()) {
+				missingL1EventsBySourceNum[sourceNum]++;
+#ifdef USE_ERS
+				ers::warning(MissingFragments(ERS_HERE, this->getEventNumber(), subevent->getNumberOfExpectedFragments() - subevent->getNumberOfFragments(),
+						SourceIDManager::sourceIdToDetectorName(SourceIDManager::sourceNumToID(*layout_, sourceNum))));
+#endif
+			}
+		}
+	}
+}
+
+bool Event::expire(const EventState expectedState, uint64_t* missingL0EventsBySourceNum,
+		uint64_t* missingL1EventsBySourceNum,
+		std::map<uint, std::map<uint, uint>>& receivedSubSourceIDsBySourceNum) {
+	const uint64_t lifecycle = lifecycle_.load(std::memory_order_acquire);
+	if (phaseOf(lifecycle) != PHASE_ACTIVE) {
+		return false;
+	}
+
+	uint64_t expected = lifecycle;
+	if (!lifecycle_.compare_exchange_strong(expected, withPhase(lifecycle, PHASE_DESTROYING),
+			std::memory_order_seq_cst)) {
+		return false;
+	}
+	if (pins_.load(std::memory_order_seq_cst) & ~FreeDeferredBit) {
+		/*
+		 * Still read by another thread: checked again later
+		 */
+		abortDestruction(PHASE_ACTIVE);
+		return false;
+	}
+
+	/*
+	 * Fragment adders registered before the CAS may still be inserting. New ones wait for DESTROYING to end
+	 */
+	waitForAdders();
+
+	/*
+	 * An L0 adder only reports the completion if it has counted the last fragment before the CAS. Events
+	 * completed by an adder after the CAS have not been handed to the trigger and are expired anyway
+	 */
+	const bool completed =
+			expectedState == EventState::BUILDING_L0 ?
+					numberOfL0FragmentsOf(lifecycle) == layout_->expectedL0PacketsPerEvent :
+					numberOfMEPFragments_ == layout_->expectedL1PacketsPerEvent;
+	if (completed || EventPool::getEventState(poolIndex_.load(std::memory_order_relaxed)) != expectedState) {
+		/*
+		 * Completed in the meantime: hand the event back keeping all fragments counted
+		 */
+		abortDestruction(PHASE_ACTIVE);
+		return false;
+	}
+
+	updateMissingEventsStats(missingL0EventsBySourceNum, missingL1EventsBySourceNum,
+			receivedSubSourceIDsBySourceNum);
+	finishDestruction();
+	return true;
+}
+
+bool Event::sweep(const uint_fast32_t currentBurstID, uint64_t* missingL0EventsBySourceNum,
+		uint64_t* missingL1EventsBySourceNum,
+		std::map<uint, std::map<uint, uint>>& receivedSubSourceIDsBySourceNum) {
+	const uint64_t lifecycle = lifecycle_.load(std::memory_order_acquire);
+	if (phaseOf(lifecycle) != PHASE_ACTIVE || burstIDOf(lifecycle) == currentBurstID) {
+		return false;
+	}
+
+	uint64_t expected = lifecycle;
+	if (!lifecycle_.compare_exchange_strong(expected, withPhase(lifecycle, PHASE_DESTROYING),
+			std::memory_order_seq_cst)) {
+		return false;
+	}
+	if (pins_.load(std::memory_order_seq_cst) & ~FreeDeferredBit) {
+		/*
+		 * Still read by another thread: swept at the next burst change
+		 */
+		abortDestruction(PHASE_ACTIVE);
+		return false;
+	}
+
+	/*
+	 * The subevents may only be read once all adders registered before the CAS have left
+	 */
+	waitForAdders();
+	if (!unfinished_) {
+		abortDestruction(PHASE_ACTIVE);
+		return false;
+	}
+
+	updateMissingEventsStats(missingL0EventsBySourceNum, missingL1EventsBySourceNum,
+			receivedSubSourceIDsBySourceNum);
+	finishDestruction();
+	return true;
+}
+
+void Event::addMissingEventsStats(const uint64_t* missingL0EventsBySourceNum,
+		const uint64_t* missingL1EventsBySourceNum) {
+	for (size_t i = 0; i != SourceIDManager::NUMBER_OF_L0_DATA_SOURCES; ++i) {
+		MissingEventsBySourceNum_[i].fetch_add(missingL0EventsBySourceNum[i],
+				std::memory_order_relaxed);
+	}
+	for (size_t i = 0; i != SourceIDManager::NUMBER_OF_L1_DATA_SOURCES; ++i) {
+		MissingL1EventsBySourceNum_[i].fetch_add(missingL1EventsBySourceNum[i],
+				std::memory_order_relaxed);
+	}
+}
+
 } /* namespace na62 */
@@ -9,20 +9,30 @@
 #ifndef EVENT_H_
 #define EVENT_H_
 
+/*
+ * The latency instrumentation is compiled in unless NO_MEASURE_TIME is defined. At runtime it can be
+ * switched off or between the TSC and the monotonic clock via Event::setTimingMode
+ */
+#ifndef NO_MEASURE_TIME
 #define MEASURE_TIME
+#endif
 
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <map>
+#include <vector>
 #include <atomic>
-#ifdef MEASURE_TIME
-#include <boost/timer/timer.hpp>
-#endif
 #include <boost/noncopyable.hpp>
-#include <tbb/spin_mutex.h>
+#include "EventPool.h"
+#include "NonZSuppressedLkrFragmentTable.h"
 #include "SourceIDManager.h"
 #include "../structs/Event.h"
 #include "../options/Logging.h"
+#ifdef MEASURE_TIME
+#include "../monitoring/LatencyStatistics.h"
+#include "../utils/Stopwatch.h"
+#endif
 
 #include <iostream>
 
@@ -42,13 +52,26 @@ namespace na62 {
 
 class Event: boost::noncopyable {
 public:
-	Event(uint_fast32_t eventNumber_);
+	/**
+	 * <poolIndex> is the index of this event in the EventPool. Events not stored in the EventPool don't
+	 * update any state array
+	 */
+	Event(uint_fast32_t eventNumber_, uint_fast32_t poolIndex = UINT32_MAX);
 	virtual ~Event();
+
+	/**
+	 * Events are cache line aligned (see member layout) which the default operator new does not guarantee.
+	 * With contiguous storage (see initialize) the memory for all Subevents is allocated here as well.
+	 */
+	static void* operator new(size_t size);
+	static void operator delete(void* ptr);
 	/**
 	 * Add an Event from a new SourceID.
 	 * return <true> if the event was the last missing one <false> if some subevents
 	 * are still missing
 	 *
+	 * If the CompletedEventDispatcher is active the completed event has already been pushed to its L0 queue
+	 *
 	 * DO NOT USE THIS METHOD IF YOUR ARE IMPLEMENTING TRIGGER ALGORITHMS
 	 */
 	bool addL0Fragment(l0::MEPFragment* e, uint_fast32_t burstID);
@@ -57,6 +80,8 @@ public:
 	 * DO NOT USE THIS METHOD IF YOUR ARE IMPLEMENTING TRIGGER ALGORITHMS
 	 *
 	 * @return [true] if the given L1 event fragment was the last one to complete the event
+	 *
+	 * If the CompletedEventDispatcher is active the completed event has already been pushed to its L1 queue
 	 */
 	bool addL1Fragment(l1::MEPFragment* fragment);
 
@@ -65,6 +90,33 @@ public:
 	 */
 	void destroy();
 
+	/**
+	 * Keeps the event and its fragments alive while other code still reads them, e.g. during the
+	 * output of an EventIovec (see EventSerializer). No thread destroys or expires a pinned event: the
+	 * destruction is deferred until the last unpin(). Must only be called by the thread owning the event
+	 * before it is freed.
+	 *
+	 * Returns false without pinning if the event has already been freed or reused for another burst, e.g.
+	 * because a destroying thread has won before the pin became visible. The event must not be read then
+	 */
+	bool pin();
+
+	/**
+	 * Releases one pin. Destroys the event if its destruction has been deferred while it was pinned and it
+	 * still belongs to the burst it has been pinned in
+	 */
+	void unpin();
+
+	/**
+	 * Returns true if the event is FREE, not pinned and no thread is adding a fragment. Used by the EventPool
+	 * to reclaim events detached from the pool (see EventPool::switchSourceLayout)
+	 */
+	bool isUnreferenced() const {
+		const uint64_t lifecycle = lifecycle_.load(std::memory_order_acquire);
+		return phaseOf(lifecycle) == PHASE_FREE && numberOfAddersOf(lifecycle) == 0
+				&& pins_.load(std::memory_order_acquire) == 0;
+	}
+
 	bool isUnfinished() const {
 		return unfinished_;
 	}
@@ -93,13 +145,15 @@ public:
 	 */
 	void setL1Processed(const uint_fast16_t L0L1TriggerTypeWord) {
 #ifdef MEASURE_TIME
-		l1ProcessingTime_ = firstEventPartAddedTime_.elapsed().wall / 1E3
-				- l0BuildingTime_;
-		//LOG_INFO("*******************l1ProcessingTime_ " << l1ProcessingTime_);
+		if (timingMode_ != TIMING_OFF) {
+			l1ProcessingTicks_ = getTicksSinceFirstEventPart() - l0BuildingTicks_;
+			LatencyStatistics::record(LATENCY_L1_PROCESSING, l1ProcessingTicks_);
+		}
 #endif
 
 		triggerTypeWord_ = L0L1TriggerTypeWord;
 		L1Processed_ = true;
+		EventPool::setEventState(poolIndex_.load(std::memory_order_relaxed), EventState::BUILDING_L1);
 	}
 
 	/**
@@ -111,21 +165,31 @@ public:
 	 */
 	void setL2Processed(const uint_fast8_t L2TriggerTypeWord) {
 #ifdef MEASURE_TIME
-		l2ProcessingTime_ = firstEventPartAddedTime_.elapsed().wall / 1E3
-				- (l1BuildingTime_ + l1ProcessingTime_ + l0BuildingTime_);
-//		LOG_INFO("*******************l2ProcessingTime_ " << l2ProcessingTime_);
+		if (timingMode_ != TIMING_OFF) {
+			l2ProcessingTicks_ = getTicksSinceFirstEventPart()
+					- (l1BuildingTicks_ + l1ProcessingTicks_ + l0BuildingTicks_);
+			LatencyStatistics::record(LATENCY_L2_PROCESSING, l2ProcessingTicks_);
+		}
 #endif
 
 		L2Accepted_ = L2TriggerTypeWord > 0;
 		// Move the L2 trigger type word to the third byte of triggerTypeWord_
 		triggerTypeWord_ |= L2TriggerTypeWord << 16;
 		unfinished_ = false;
+		EventPool::setEventState(poolIndex_.load(std::memory_order_relaxed), EventState::DONE);
 	}
 
 	uint_fast32_t getEventNumber() const {
 		return eventNumber_;
 	}
 
+	/**
+	 * Index of this event in the EventPool
+	 */
+	uint_fast32_t getPoolIndex() const {
+		return poolIndex_.load(std::memory_order_relaxed);
+	}
+
 	uint_fast32_t getTriggerTypeWord() const {
 		return triggerTypeWord_;
 	}
@@ -236,7 +300,7 @@ public:
 	 * Will return the bust number at which this event has been taken
 	 */
 	uint_fast32_t getBurstID() const {
-		return burstID_;
+		return burstIDOf(lifecycle_.load(std::memory_order_acquire));
 	}
 
 	/*
@@ -256,7 +320,7 @@ public:
 	 */
 	inline const l0::Subevent* getL0SubeventBySourceID(
 			const uint_fast8_t sourceID) const {
-		return L0Subevents[SourceIDManager::sourceIDToNum(std::move(sourceID))];
+		return L0Subevents[SourceIDManager::sourceIDToNum(*layout_, std::move(sourceID))];
 	}
 
 
@@ -277,82 +341,83 @@ public:
 	 */
 	inline const l1::Subevent* getL1SubeventBySourceID(
 			const uint_fast8_t sourceID) const {
-		return L1Subevents[SourceIDManager::l1SourceIDToNum(std::move(sourceID))];
+		return L1Subevents[SourceIDManager::l1SourceIDToNum(*layout_, std::move(sourceID))];
 	}
 
 
 	inline const l0::Subevent* getCEDARSubevent() const {
-		return L0Subevents[SourceIDManager::sourceIDToNum(SOURCE_ID_CEDAR)];
+		return L0Subevents[SourceIDManager::sourceIDToNum(*layout_, SOURCE_ID_CEDAR)];
 	}
 	inline const l0::Subevent* getL0GTKSubevent() const {
-		return L0Subevents[SourceIDManager::sourceIDToNum(SOURCE_ID_GTK)];
+		return L0Subevents[SourceIDManager::sourceIDToNum(*layout_, SOURCE_ID_GTK)];
 	}
 	inline const l0::Subevent* getCHANTISubevent() const {
-		return L0Subevents[SourceIDManager::sourceIDToNum(SOURCE_ID_CHANTI)];
+		return L0Subevents[SourceIDManager::sourceIDToNum(*layout_, SOURCE_ID_CHANTI)];
 	}
 	inline const l0::Subevent* getLAVSubevent() const {
-		return L0Subevents[SourceIDManager::sourceIDToNum(SOURCE_ID_LAV)];
+		return L0Subevents[SourceIDManager::sourceIDToNum(*layout_, SOURCE_ID_LAV)];
 	}
 	inline const l0::Subevent* getSTRAWSubevent() const {
-		return L0Subevents[SourceIDManager::sourceIDToNum(SOURCE_ID_STRAW)];
+		return L0Subevents[SourceIDManager::sourceIDToNum(*layout_, SOURCE_ID_STRAW)];
 	}
 	inline const l0::Subevent* getCHODSubevent() const {
-		return L0Subevents[SourceIDManager::sourceIDToNum(SOURCE_ID_CHOD)];
+		return L0Subevents[SourceIDManager::sourceIDToNum(*layout_, SOURCE_ID_CHOD)];
 	}
 	inline const l0::Subevent* getRICHSubevent() const {
-		return L0Subevents[SourceIDManager::sourceIDToNum(SOURCE_ID_RICH)];
+		return L0Subevents[SourceIDManager::sourceIDToNum(*layout_, SOURCE_ID_RICH)];
 	}
 	inline const l0::Subevent* getIRCSubevent() const {
-		return L0Subevents[SourceIDManager::sourceIDToNum(SOURCE_ID_IRC)];
+		return L0Subevents[SourceIDManager::sourceIDToNum(*layout_, SOURCE_ID_IRC)];
 	}
 	inline const l0::Subevent* getMUV3Subevent() const {
-		return L0Subevents[SourceIDManager::sourceIDToNum(SOURCE_ID_MUV3)];
+		return L0Subevents[SourceIDManager::sourceIDToNum(*layout_, SOURCE_ID_MUV3)];
 	}
 	inline const l0::Subevent* getSACSubevent() const {
-		return L0Subevents[SourceIDManager::sourceIDToNum(SOURCE_ID_SAC)];
+		return L0Subevents[SourceIDManager::sourceIDToNum(*layout_, SOURCE_ID_SAC)];
 	}
 	inline const l0::Subevent* getL0TPSubevent() const {
-		return L0Subevents[SourceIDManager::sourceIDToNum(SOURCE_ID_L0TP)];
+		return L0Subevents[SourceIDManager::sourceIDToNum(*layout_, SOURCE_ID_L0TP)];
 	}
 	inline const l0::Subevent* getL1ResultSubevent() const {
-		return L0Subevents[SourceIDManager::sourceIDToNum(SOURCE_ID_L1)];
+		return L0Subevents[SourceIDManager::sourceIDToNum(*layout_, SOURCE_ID_L1)];
 	}
 	inline const l0::Subevent* getL2ResultSubevent() const {
-		return L0Subevents[SourceIDManager::sourceIDToNum(SOURCE_ID_L2)];
+		return L0Subevents[SourceIDManager::sourceIDToNum(*layout_, SOURCE_ID_L2)];
 	}
 	inline const l0::Subevent* getNSTDSubevent() const {
-		return L0Subevents[SourceIDManager::sourceIDToNum(SOURCE_ID_NSTD)];
+		return L0Subevents[SourceIDManager::sourceIDToNum(*layout_, SOURCE_ID_NSTD)];
 	}
 
 // L1 dets
 	inline const l1::Subevent* getL1GTKSubevent() const {
-		return L1Subevents[SourceIDManager::l1SourceIDToNum(SOURCE_ID_GTK)];
+		return L1Subevents[SourceIDManager::l1SourceIDToNum(*layout_, SOURCE_ID_GTK)];
 	}
 	inline const l1::Subevent* getLKrSubevent() const {
-		return L1Subevents[SourceIDManager::l1SourceIDToNum(SOURCE_ID_LKr)];
+		return L1Subevents[SourceIDManager::l1SourceIDToNum(*layout_, SOURCE_ID_LKr)];
 	}
 
 	inline l1::Subevent* getMuv1Subevent() const {
-		return L1Subevents[SourceIDManager::sourceIDToNum(SOURCE_ID_MUV1)] ;
+		return L1Subevents[SourceIDManager::sourceIDToNum(*layout_, SOURCE_ID_MUV1)] ;
 	}
 
 	inline l1::Subevent* getMuv2Subevent() const {
-		return L1Subevents[SourceIDManager::sourceIDToNum(SOURCE_ID_MUV2)] ;
+		return L1Subevents[SourceIDManager::sourceIDToNum(*layout_, SOURCE_ID_MUV2)] ;
 	}
 
 	/**
-	 * Get the received non zero suppressed LKr Event by the crateCREAMID
+	 * Get the received non zero suppressed LKr Event by the crateCREAMID or nullptr if it has not been received
 	 */
 	inline l1::MEPFragment* getNonZSuppressedLkrFragment(const uint_fast16_t crateCREAMID) const {
-		return nonSuppressedLkrFragmentsByCrateCREAMID.at(crateCREAMID);
+		NonZSuppressedLkrFragmentTable* table = nonSuppressedLkrFragments_.load(std::memory_order_acquire);
+		return table == nullptr ? nullptr : table->find(crateCREAMID);
 	}
 
 	/**
-	 * Returns the map containing all received non zero suppressed LKR Events.
-	 * The keys are the 16-bit crate-ID and CREAM-ID concatenations
+	 * Returns a view on all received non zero suppressed LKR Events without copying them.
+	 * The elements are pairs of the 16-bit crate-ID and CREAM-ID concatenation and the fragment
 	 */
-	inline std::map<uint_fast16_t, l1::MEPFragment*> getNonSuppressedLkrFragments() const {
-		return nonSuppressedLkrFragmentsByCrateCREAMID;
+	inline NonZSuppressedLkrFragmentTable::View getNonSuppressedLkrFragments() const {
+		return NonZSuppressedLkrFragmentTable::View(nonSuppressedLkrFragments_.load(std::memory_order_acquire));
 	}
 
 	/*
@@ -380,6 +445,44 @@ public:
 	 * Find the missing sourceIDs
 	 */
 	void updateMissingEventsStats();
+
+	/*
+	 * Same as updateMissingEventsStats() but increments the given per source counters instead of the global
+	 * ones. The subIDs received for every incomplete subevent are counted in <receivedSubSourceIDsBySourceNum>.
+	 * Used to collect the statistics per thread (see EventPool::sweepUnfinishedEvents)
+	 */
+	void updateMissingEventsStats(uint64_t* missingL0EventsBySourceNum,
+			uint64_t* missingL1EventsBySourceNum,
+			std::map<uint, std::map<uint, uint>>& receivedSubSourceIDsBySourceNum);
+
+	/*
+	 * Frees the event if it is still incomplete in <expectedState>. The missing fragments are counted like in
+	 * updateMissingEventsStats(uint64_t*, uint64_t*, ...). Returns false if the event has been completed or
+	 * destroyed in the meantime. Used by the EventTimeoutHandler
+	 *
+	 * DO NOT USE THIS METHOD IF YOUR ARE IMPLEMENTING TRIGGER ALGORITHMS
+	 */
+	bool expire(const EventState expectedState, uint64_t* missingL0EventsBySourceNum,
+			uint64_t* missingL1EventsBySourceNum,
+			std::map<uint, std::map<uint, uint>>& receivedSubSourceIDsBySourceNum);
+
+	/*
+	 * Frees the event if it is unfinished and belongs to another burst than <currentBurstID>. The missing
+	 * fragments are counted like in expire(). Returns false if the event is pinned, of the current burst,
+	 * finished or destroyed by another thread. Used by EventPool::sweepUnfinishedEvents
+	 *
+	 * DO NOT USE THIS METHOD IF YOUR ARE IMPLEMENTING TRIGGER ALGORITHMS
+	 */
+	bool sweep(const uint_fast32_t currentBurstID, uint64_t* missingL0EventsBySourceNum,
+			uint64_t* missingL1EventsBySourceNum,
+			std::map<uint, std::map<uint, uint>>& receivedSubSourceIDsBySourceNum);
+
+	/*
+	 * Adds the counters collected by updateMissingEventsStats(uint64_t*, uint64_t*, ...) to the global ones
+	 */
+	static void addMissingEventsStats(const uint64_t* missingL0EventsBySourceNum,
+			const uint64_t* missingL1EventsBySourceNum);
+
 	static uint_fast64_t getMissingL0EventsBySourceNum(const uint_fast16_t sourceNum) {
 		return MissingEventsBySourceNum_[sourceNum];
 	}
@@ -395,49 +498,249 @@ public:
     }
 
 #ifdef MEASURE_TIME
+	/*
+	 * TIMING_OFF: No timestamps are taken
+	 * TIMING_TSC: Invariant TSC deltas converted with Stopwatch::GetCPUFrequency (lowest overhead)
+	 * TIMING_FULL: Monotonic system clock (default)
+	 */
+	enum TimingMode {
+		TIMING_OFF, TIMING_TSC, TIMING_FULL
+	};
+
+	/*
+	 * Selects the clock for the latency measurements. TIMING_TSC falls back to TIMING_FULL if the CPU does not
+	 * provide an invariant TSC. Must be called before the first fragment is added
+	 */
+	static void setTimingMode(TimingMode mode);
+
+	static TimingMode getTimingMode() {
+		return timingMode_;
+	}
+
 	/*
 	 * Returns the number of wall microseconds since the first event part has been added to this event
 	 */
 	u_int32_t getTimeSinceFirstMEPReceived() const {
-		return firstEventPartAddedTime_.elapsed().wall / 1E3;
+		return ticksToMicroseconds(getTicksSinceFirstEventPart());
 	}
 
 	/*
 	 * Returns the number of wall microseconds passed between the first and last L0 MEP received
 	 */
 	u_int32_t getL0BuildingTime() const {
-		return l0BuildingTime_;
+		return ticksToMicroseconds(l0BuildingTicks_);
 	}
 
 	/*
 	 * Returns the number of wall microseconds passed between the last L0 MEP received and the end of the L1 processing
 	 */
 	u_int32_t getL1ProcessingTime() const {
-		return l1ProcessingTime_;
+		return ticksToMicroseconds(l1ProcessingTicks_);
 	}
 
 	/*
 	 * Returns the number of wall microseconds passed between the  end of the L1 processing and the last LKr MEP received
 	 */
 	u_int32_t getL1BuildingTime() const {
-		return l1BuildingTime_;
+		return ticksToMicroseconds(l1BuildingTicks_);
 	}
 
 	/*
 	 * Returns the number of wall microseconds passed between the  LKr MEP received and the end of the L2 processing
 	 */
 	u_int32_t getL2ProcessingTime() const {
-		return l2ProcessingTime_;
+		return ticksToMicroseconds(l2ProcessingTicks_);
+	}
+
+	/*
+	 * Same as the methods above but in ticks of the current timing mode (see getTicksPerMicrosecond)
+	 */
+	uint64_t getL0BuildingTicks() const {
+		return l0BuildingTicks_;
+	}
+
+	uint64_t getL1ProcessingTicks() const {
+		return l1ProcessingTicks_;
+	}
+
+	uint64_t getL1BuildingTicks() const {
+		return l1BuildingTicks_;
+	}
+
+	uint64_t getL2ProcessingTicks() const {
+		return l2ProcessingTicks_;
+	}
+
+	static double getTicksPerMicrosecond() {
+		return ticksPerMicrosecond_;
 	}
 #endif
 
-	static void initialize(bool printCompletedSourceIDs);
+	/**
+	 * If <useContiguousStorage> is set every Event is allocated together with all its L0 and L1 Subevents and
+	 * their fragment tables in one single memory block. The offsets within this block are computed from the
+	 * SourceIDManager which therefore has to be initialized before. This must be called before the first
+	 * Event is created.
+	 */
+	static void initialize(bool printCompletedSourceIDs,
+			bool useContiguousStorage = false);
+
+	static inline bool isUsingContiguousStorage() {
+		return useContiguousStorage_;
+	}
+
+	/*
+	 * Number of bytes needed by one event with contiguous storage
+	 */
+	static inline size_t getContiguousStorageSize() {
+		return contiguousStorageSize_;
+	}
+
+	/**
+	 * Same as initialize with the options of the last call. Used by EventPool::reconfigure after the
+	 * SourceIDManager has been initialized with a new layout
+	 */
+	static void reinitialize() {
+		initialize(printCompletedSourceIDs_, useContiguousStorage_);
+	}
+
+	/**
+	 * Moves the event to the current layout of the SourceIDManager and every Subevent to the sourceID
+	 * assigned to its sourceNum by that layout. Only valid if the layout has the same shape as the one of
+	 * this event (see SourceLayout::hasSameShape). The event must not be used by any other thread
+	 */
+	void reassignSourceIDs();
+
+	/**
+	 * Moves the event to the current layout of the SourceIDManager (see reassignSourceIDs) if it is FREE.
+	 * Returns false if the event is in use: it keeps its layout and moves to the current one as soon as it
+	 * is freed. Only valid if the layouts have the same shape. Used by EventPool::switchSourceLayout
+	 */
+	bool moveToCurrentLayout();
+
+	/**
+	 * The source layout this event has been built for. It stays valid as long as the event exists even if
+	 * the SourceIDManager has switched to a new layout in the meantime
+	 */
+	inline const SourceLayout* getSourceLayout() const {
+		return layout_;
+	}
+
+	/**
+	 * Detaches the event from the EventPool when the pool is rebuilt for a new source layout: all
+	 * following updates of the pool state array are ignored (see EventPool::switchSourceLayout)
+	 */
+	void retire() {
+		poolIndex_.store(UINT32_MAX, std::memory_order_relaxed);
+	}
 
 private:
-	void setBurstID(const uint_fast32_t burstID) {
-		burstID_ = burstID;
+	/*
+	 * The life cycle of an event is stored in one atomic word:
+	 * burst ID (bits 32-63) | adders (bits 20-31) | phase (bits 16-19) | number of L0 fragments received (bits 0-15)
+	 *
+	 * FREE -> ACTIVE: First L0 fragment of a burst
+	 * ACTIVE -> DESTROYING: destroy(), expire() or a fragment of a newer burst has been received
+	 * DESTROYING -> ACTIVE/FREE: expire() found the event completed or the event is pinned (see pin())
+	 * DESTROYING -> FREE: The thread that has moved the event to DESTROYING has cleared it
+	 *
+	 * A thread only inserts a fragment after registering as adder with the same CAS that checks the phase
+	 * and burst ID (see beginAddingL0Fragment). The destroying thread waits until all adders have left
+	 * before clearing the subevents and giving back the non zero suppressed LKr table so that no fragment
+	 * is inserted into a subevent or table being destroyed.
+	 *
+	 * A thread moving a pinned event to DESTROYING moves it back right away and leaves the destruction to
+	 * the last unpin().
+	 */
+	enum LifecyclePhase {
+		PHASE_FREE = 0, PHASE_ACTIVE = 1, PHASE_DESTROYING = 2
+	};
+
+	static const uint64_t AdderUnit = 1ULL << 20;
+
+	static inline uint64_t makeLifecycle(const uint_fast32_t burstID,
+			const LifecyclePhase phase, const uint_fast16_t numberOfL0Fragments) {
+		return ((uint64_t) burstID << 32) | ((uint64_t) phase << 16)
+				| (numberOfL0Fragments & 0xFFFF);
+	}
+
+	static inline uint_fast32_t burstIDOf(const uint64_t lifecycle) {
+		return lifecycle >> 32;
+	}
+
+	static inline LifecyclePhase phaseOf(const uint64_t lifecycle) {
+		return (LifecyclePhase) ((lifecycle >> 16) & 0xF);
+	}
+
+	static inline uint_fast16_t numberOfL0FragmentsOf(const uint64_t lifecycle) {
+		return lifecycle & 0xFFFF;
+	}
+
+	static inline uint_fast16_t numberOfAddersOf(const uint64_t lifecycle) {
+		return (lifecycle >> 20) & 0xFFF;
+	}
+
+	/*
+	 * Same lifecycle with another phase. The burst ID and all counters are kept
+	 */
+	static inline uint64_t withPhase(const uint64_t lifecycle, const LifecyclePhase phase) {
+		return (lifecycle & ~(0xFULL << 16)) | ((uint64_t) phase << 16);
+	}
+
+	/*
+	 * Registers the calling thread as adder of an L0 fragment of <burstID>. Frees the event first if it still
+	 * belongs to an older burst. Returns false if the fragment belongs to an older burst than the event
+	 */
+	bool beginAddingL0Fragment(const uint_fast32_t burstID);
+
+	/*
+	 * Registers the calling thread as adder of an L1 fragment. Returns false if the event is not ACTIVE
+	 */
+	bool beginAddingL1Fragment();
+
+	inline void leaveAdding() {
+		lifecycle_.fetch_sub(AdderUnit, std::memory_order_acq_rel);
 	}
 
+	/*
+	 * Moves the event from FREE or ACTIVE to DESTROYING. Returns false if another thread is already destroying it
+	 * or if the event is pinned. In the latter case the last unpin() destroys it. If true is returned the calling
+	 * thread has to call finishDestruction()
+	 */
+	bool tryBeginDestruction();
+
+	/*
+	 * Implements reassignSourceIDs for the given layout
+	 */
+	void moveToLayout(const SourceLayout* layout);
+
+	/*
+	 * Called after moving the event to DESTROYING: returns true and marks the destruction as deferred if the
+	 * event is pinned
+	 */
+	bool deferDestructionIfPinned();
+
+	/*
+	 * Moves the event from DESTROYING back to the given phase keeping all fragments
+	 */
+	void abortDestruction(const LifecyclePhase phase);
+
+	/*
+	 * Clears all subevents and sets the event FREE. An event of the pool still built for a previous layout of
+	 * the same shape is moved to the current layout before
+	 */
+	void finishDestruction();
+
+	/*
+	 * Waits until the thread destroying this event has finished
+	 */
+	void waitForDestruction() const;
+
+	/*
+	 * Waits until all threads adding fragments have left. Called after moving the event to DESTROYING
+	 */
+	void waitForAdders() const;
+
 	void setEventNumber(uint_fast32_t eventNumber) {
 		eventNumber_ = eventNumber;
 	}
@@ -448,16 +751,33 @@ private:
 
 	/*
 	 * Don't forget to reset new variables in Event::reset()!
+	 *
+	 * The members are grouped by the threads writing them and every group starts at a new cache line.
+	 * This way receiver threads adding fragments do not invalidate the cache lines used by the trigger
+	 * workers of the same event and vice versa.
+	 */
+
+	/*
+	 * Read mostly: only written when the event is created or destroyed. Shares the cache line with the vtable pointer
 	 */
 	std::atomic<uint_fast32_t> eventNumber_;
-	std::atomic<uint_fast8_t> numberOfL0Fragments_;
+	std::atomic<uint_fast32_t> poolIndex_; // UINT32_MAX once retired
+	l0::Subevent ** L0Subevents;
+	l1::Subevent ** L1Subevents;
+	const SourceLayout* layout_; // Referenced by this event
+
+	/*
+	 * Written by the receiver threads for every fragment
+	 */
+	alignas(64) std::atomic<uint64_t> lifecycle_;
 	std::atomic<uint_fast16_t> numberOfMEPFragments_;
+	std::atomic<bool> unfinished_;
+	std::atomic<bool> lastEventOfBurst_;
 
 	/*
-	 * To be added within L1 trigger process
+	 * Written by the L1 and L2 trigger workers
 	 */
-	std::atomic<uint_fast32_t> burstID_;
-	std::atomic<uint_fast32_t> triggerTypeWord_;
+	alignas(64) std::atomic<uint_fast32_t> triggerTypeWord_;
 	std::atomic<uint_fast16_t> triggerFlags_;
 	std::atomic<uint_fast32_t> timestamp_;
 	std::atomic<uint_fast8_t> finetime_;
@@ -465,28 +785,69 @@ private:
 	std::atomic<uint_fast32_t> processingID_;
 
 	std::atomic<bool> requestZeroSuppressedCreamData_;
+	std::atomic<uint_fast16_t>  nonZSuppressedDataRequestedNum;
 
-	l0::Subevent ** L0Subevents;
-	l1::Subevent ** L1Subevents;
+	std::atomic<bool> L1Processed_; /// ATOMICCCCC !!!!
+	std::atomic<bool> L2Accepted_;
 
-	std::atomic<uint_fast16_t>  nonZSuppressedDataRequestedNum;
+	/*
+	 * Cold data
+	 */
 
 	/*
-	 * zSuppressedLkrFragmentsByLocalCREAMID[SourceIDManager::getLocalCREAMID()] is the cream event fragment of the
-	 * corresponding cream/create
+	 * Non zero suppressed cream event fragments by crate/CREAM ID. The table is taken from the pool when the
+	 * first fragment arrives and given back when the event is destroyed
 	 */
+	alignas(64) std::atomic<NonZSuppressedLkrFragmentTable*> nonSuppressedLkrFragments_;
 
-	std::map<uint_fast16_t, l1::MEPFragment*> nonSuppressedLkrFragmentsByCrateCREAMID;
+	/*
+	 * Number of pins (see pin()) | FreeDeferredBit if the event has been freed while being pinned
+	 */
+	std::atomic<uint32_t> pins_;
+	static const uint32_t FreeDeferredBit = 1u << 31;
+	/*
+	 * Burst ID of the lifecycle the event has been pinned in. A deferred destruction is dropped if the event
+	 * has been destroyed and reused in the meantime
+	 */
+	std::atomic<uint32_t> pinnedBurstID_;
 
-	std::atomic<bool> L1Processed_; /// ATOMICCCCC !!!!
+#ifdef MEASURE_TIME
+	/*
+	 * Timestamp of the first L0 fragment, 0 if no fragment has been added yet
+	 */
+	std::atomic<uint64_t> firstEventPartAddedTicks_;
 
-	std::atomic<bool> L2Accepted_;
-	std::atomic<bool> unfinished_;
+	/*
+	 * Intervals in ticks of the current timing mode
+	 */
+	std::atomic<uint64_t> l0BuildingTicks_;
+	std::atomic<uint64_t> l1ProcessingTicks_;
+	std::atomic<uint64_t> l1BuildingTicks_;
+	std::atomic<uint64_t> l2ProcessingTicks_;
 
-	std::atomic<bool> lastEventOfBurst_;
+	static TimingMode timingMode_;
+	static double ticksPerMicrosecond_;
+
+	static inline uint64_t getTimingTicks() {
+		if (timingMode_ == TIMING_TSC) {
+			return Stopwatch::GetTicks();
+		}
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
 
-	tbb::spin_mutex destroyMutex_;
-	tbb::spin_mutex unfinishedEventMutex_;
+	inline uint64_t getTicksSinceFirstEventPart() const {
+		const uint64_t firstEventPartAddedTicks = firstEventPartAddedTicks_;
+		if (timingMode_ == TIMING_OFF || firstEventPartAddedTicks == 0) {
+			return 0;
+		}
+		return getTimingTicks() - firstEventPartAddedTicks;
+	}
+
+	static inline u_int32_t ticksToMicroseconds(const uint64_t ticks) {
+		return ticks / ticksPerMicrosecond_;
+	}
+#endif
 
 	static std::atomic<uint64_t>* MissingEventsBySourceNum_;
 	static std::atomic<uint64_t>* MissingL1EventsBySourceNum_;
@@ -494,17 +855,16 @@ private:
 	static std::atomic<uint64_t> nonRequestsL1FramesReceived_;
 	static bool printCompletedSourceIDs_;
 
-#ifdef MEASURE_TIME
-	boost::timer::cpu_timer firstEventPartAddedTime_;
-
 	/*
-	 * Times in microseconds
-	 */
-	std::atomic<uint_fast32_t> l0BuildingTime_;
-	std::atomic<uint_fast32_t> l1ProcessingTime_;
-	std::atomic<uint_fast32_t> l1BuildingTime_;
-	std::atomic<uint_fast32_t> l2ProcessingTime_;
-#endif
+	 * Layout of the contiguous storage: The Event is followed by the L0 and L1 Subevent tables and all
+	 * Subevents, each directly followed by its fragment table. All offsets are relative to <this>.
+	 */
+	static bool useContiguousStorage_;
+	static size_t contiguousStorageSize_;
+	static size_t l0SubeventTableOffset_;
+	static size_t l1SubeventTableOffset_;
+	static std::vector<size_t> l0SubeventOffsets_;
+	static std::vector<size_t> l1SubeventOffsets_;
 };
 
 } /* namespace na62 */
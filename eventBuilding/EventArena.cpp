@@ -0,0 +1,203 @@
+/*
+ * EventArena.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "EventArena.h"
+
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <boost/timer/timer.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+
+#include "../options/Logging.h"
+#include "../utils/NumaTopology.h"
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+namespace na62 {
+
+bool EventArena::enabled_ = false;
+EventArena::PageSize EventArena::pageSize_ = EventArena::PAGES_2MB;
+bool EventArena::lockMemory_ = false;
+std::vector<EventArena::Region> EventArena::regions_;
+size_t EventArena::slotSize_ = 0;
+uint_fast32_t EventArena::numberOfPartitions_ = 1;
+uint_fast32_t EventArena::partitionBlockSize_ = 1;
+uint64_t EventArena::minorFaultsAtLastReport_ = 0;
+uint64_t EventArena::majorFaultsAtLastReport_ = 0;
+
+static const size_t SmallPageSize = 4096;
+static const size_t HugepageSize2MB = 2 * 1024 * 1024;
+static const size_t HugepageSize1GB = 1024 * 1024 * 1024;
+
+static void getPageFaults(uint64_t& minorFaults, uint64_t& majorFaults) {
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	minorFaults = usage.ru_minflt;
+	majorFaults = usage.ru_majflt;
+}
+
+EventArena::Region EventArena::mapRegion(const size_t length, const uint node) {
+	Region region;
+	void* memory = MAP_FAILED;
+
+	if (pageSize_ == PAGES_1GB) {
+		region.pageSize = HugepageSize1GB;
+		region.length = (length + region.pageSize - 1) & ~(region.pageSize - 1);
+		memory = mmap(nullptr, region.length, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_1GB, -1, 0);
+		if (memory == MAP_FAILED) {
+			LOG_WARNING("No 1 GB hugepages available for the event arena of node " << node << ". Trying 2 MB hugepages");
+		}
+	}
+	if (memory == MAP_FAILED && pageSize_ != PAGES_TRANSPARENT) {
+		region.pageSize = HugepageSize2MB;
+		region.length = (length + region.pageSize - 1) & ~(region.pageSize - 1);
+		memory = mmap(nullptr, region.length, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_2MB, -1, 0);
+		if (memory == MAP_FAILED) {
+			LOG_WARNING("No 2 MB hugepages available for the event arena of node " << node << ". Falling back to transparent hugepages");
+		}
+	}
+	if (memory == MAP_FAILED) {
+		region.pageSize = SmallPageSize;
+		region.length = (length + HugepageSize2MB - 1) & ~(HugepageSize2MB - 1);
+		memory = mmap(nullptr, region.length, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (memory == MAP_FAILED) {
+			LOG_ERROR("Unable to allocate " << region.length << " B for the event arena of node " << node);
+			exit(1);
+		}
+		madvise(memory, region.length, MADV_HUGEPAGE);
+	}
+	NumaTopology::bindMemory(memory, region.length, node);
+
+	region.begin = static_cast<char*>(memory);
+	return region;
+}
+
+void EventArena::prefault(const Region& region, const uint node) {
+	/*
+	 * Touch one byte per page with every CPU of the owning node. The chunks are page aligned so that every
+	 * page is faulted by exactly one thread
+	 */
+	const size_t numberOfPages = region.length / region.pageSize;
+	const size_t numberOfThreads = std::max<size_t>(1,
+			std::min<size_t>(NumaTopology::getCPUsOfNode(node).size(), numberOfPages));
+	const size_t pagesPerThread = (numberOfPages + numberOfThreads - 1) / numberOfThreads;
+
+	std::vector<std::thread> threads;
+	for (size_t thread = 0; thread != numberOfThreads; ++thread) {
+		const size_t firstPage = thread * pagesPerThread;
+		const size_t lastPage = std::min(firstPage + pagesPerThread, numberOfPages);
+		threads.push_back(std::thread([&region, node, firstPage, lastPage]() {
+			NumaTopology::runOnNode(node, [&region, firstPage, lastPage]() {
+				for (size_t page = firstPage; page < lastPage; ++page) {
+					*reinterpret_cast<volatile char*>(region.begin + page * region.pageSize) = 0;
+				}
+			});
+		}));
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	if (lockMemory_ && mlock(region.begin, region.length) != 0) {
+		LOG_WARNING("Unable to lock the " << region.length << " B event arena of node " << node << " into memory. Check RLIMIT_MEMLOCK");
+	}
+}
+
+void EventArena::allocate(uint_fast32_t poolSize, size_t slotSize, uint_fast32_t numberOfPartitions,
+		uint_fast32_t partitionBlockSize) {
+	boost::timer::cpu_timer allocationTimer;
+	NumaTopology::initialize();
+	uint64_t minorFaults, majorFaults;
+	getPageFaults(minorFaults, majorFaults);
+
+	/*
+	 * Number of pool indices owned by every partition (see EventPool::getNumaNodeOfIndex)
+	 */
+	const uint_fast32_t blocksPerRound = numberOfPartitions * partitionBlockSize;
+	std::vector<size_t> lengths(numberOfPartitions);
+	for (uint_fast32_t partition = 0; partition != numberOfPartitions; ++partition) {
+		const uint_fast32_t remainder = poolSize % blocksPerRound;
+		const uint_fast32_t firstOfPartition = partition * partitionBlockSize;
+		const uint_fast32_t eventsInLastRound =
+				remainder > firstOfPartition ?
+						std::min(remainder - firstOfPartition, partitionBlockSize) : 0;
+		lengths[partition] = ((poolSize / blocksPerRound) * partitionBlockSize + eventsInLastRound)
+				* slotSize;
+	}
+
+	bool reuseRegions = regions_.size() == numberOfPartitions;
+	for (uint_fast32_t partition = 0; reuseRegions && partition != numberOfPartitions; ++partition) {
+		reuseRegions = regions_[partition].length >= lengths[partition];
+	}
+
+	slotSize_ = slotSize;
+	numberOfPartitions_ = numberOfPartitions;
+	partitionBlockSize_ = partitionBlockSize;
+	if (reuseRegions) {
+		return;
+	}
+
+	release();
+	regions_.resize(numberOfPartitions);
+	std::vector<std::thread> threads;
+	for (uint_fast32_t partition = 0; partition != numberOfPartitions; ++partition) {
+		threads.push_back(std::thread([partition, &lengths]() {
+			regions_[partition] = mapRegion(std::max<size_t>(lengths[partition], 1), partition);
+			prefault(regions_[partition], partition);
+		}));
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	uint64_t minorFaultsAfter, majorFaultsAfter;
+	getPageFaults(minorFaultsAfter, majorFaultsAfter);
+	minorFaultsAtLastReport_ = minorFaultsAfter;
+	majorFaultsAtLastReport_ = majorFaultsAfter;
+
+	size_t totalLength = 0;
+	for (const Region& region : regions_) {
+		totalLength += region.length;
+	}
+	LOG_INFO("Prefaulted " << totalLength / (1024 * 1024) << " MB event arena in " << numberOfPartitions
+			<< " partition(s) with " << regions_[0].pageSize / 1024 << " kB pages" << (lockMemory_ ? " (locked)" : "")
+			<< " in " << allocationTimer.elapsed().wall / 1000000 << " ms causing "
+			<< minorFaultsAfter - minorFaults << " minor and " << majorFaultsAfter - majorFaults << " major page faults");
+}
+
+void EventArena::release() {
+	for (const Region& region : regions_) {
+		munmap(region.begin, region.length);
+	}
+	regions_.clear();
+}
+
+void EventArena::reportPageFaults(const uint_fast32_t burstID) {
+	if (!isAllocated()) {
+		return;
+	}
+	uint64_t minorFaults, majorFaults;
+	getPageFaults(minorFaults, majorFaults);
+	LOG_INFO("Page faults during burst " << burstID << ": " << minorFaults - minorFaultsAtLastReport_
+			<< " minor, " << majorFaults - majorFaultsAtLastReport_ << " major");
+	minorFaultsAtLastReport_ = minorFaults;
+	majorFaultsAtLastReport_ = majorFaults;
+}
+
+} /* namespace na62 */
@@ -0,0 +1,104 @@
+/*
+ * EventArena.h
+ *
+ * Memory of all events of the EventPool with contiguous storage (see Event::initialize). Every NUMA partition
+ * of the pool gets one mmaped region, preferably backed by 2 MB or 1 GB hugepages, that is cut into slots of
+ * Event::getContiguousStorageSize() bytes. All pages are touched by several threads of the owning node before
+ * the first event is created and may be locked into memory so that no page fault slows down the first burst.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#pragma once
+#ifndef EVENTARENA_H_
+#define EVENTARENA_H_
+
+#include <sys/types.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace na62 {
+
+class EventArena {
+public:
+	enum PageSize {
+		PAGES_TRANSPARENT, // Normal pages with transparent hugepages advised
+		PAGES_2MB,
+		PAGES_1GB
+	};
+
+	/**
+	 * Must be called before EventPool::initialize to allocate the events in the arena. If no hugepages of
+	 * <pageSize> are available smaller pages are used. If <lockMemory> is set the regions are mlocked.
+	 */
+	static void enable(PageSize pageSize = PAGES_2MB, bool lockMemory = false) {
+		enabled_ = true;
+		pageSize_ = pageSize;
+		lockMemory_ = lockMemory;
+	}
+
+	static inline bool isEnabled() {
+		return enabled_;
+	}
+
+	/**
+	 * Called by the EventPool: allocates and pre-faults one region per partition with a slot of <slotSize>
+	 * bytes for every pool index. The index to partition mapping is the one of EventPool::getNumaNodeOfIndex.
+	 * Existing regions are reused if they are large enough.
+	 */
+	static void allocate(uint_fast32_t poolSize, size_t slotSize, uint_fast32_t numberOfPartitions,
+			uint_fast32_t partitionBlockSize);
+
+	/**
+	 * Unmaps all regions. No event may be stored in the arena anymore
+	 */
+	static void release();
+
+	static inline bool isAllocated() {
+		return !regions_.empty();
+	}
+
+	/**
+	 * Returns the memory reserved for the event at the given pool index
+	 */
+	static inline char* getStorage(const uint_fast32_t index) {
+		const uint_fast32_t blocksPerRound = numberOfPartitions_ * partitionBlockSize_;
+		const uint_fast32_t partition = (index / partitionBlockSize_) % numberOfPartitions_;
+		const uint_fast32_t localIndex = (index / blocksPerRound) * partitionBlockSize_
+				+ index % partitionBlockSize_;
+		return regions_[partition].begin + localIndex * slotSize_;
+	}
+
+	/**
+	 * Logs the number of page faults of the process since the last call (or the allocation). Called by the
+	 * BurstIdHandler at every burst change
+	 */
+	static void reportPageFaults(const uint_fast32_t burstID);
+
+private:
+	struct Region {
+		char* begin;
+		size_t length;
+		size_t pageSize;
+	};
+
+	static Region mapRegion(const size_t length, const uint node);
+	static void prefault(const Region& region, const uint node);
+
+	static bool enabled_;
+	static PageSize pageSize_;
+	static bool lockMemory_;
+
+	static std::vector<Region> regions_;
+	static size_t slotSize_;
+	static uint_fast32_t numberOfPartitions_;
+	static uint_fast32_t partitionBlockSize_;
+
+	static uint64_t minorFaultsAtLastReport_;
+	static uint64_t majorFaultsAtLastReport_;
+};
+
+} /* namespace na62 */
+
+#endif /* EVENTARENA_H_ */
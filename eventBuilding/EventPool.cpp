@@ -7,62 +7,77 @@
 
 #include "EventPool.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include <tbb/tbb.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <boost/timer/timer.hpp>
+#include <algorithm>
 #include <thread>
 #include <iostream>
+#include <map>
 
 #include "../exceptions/CommonExceptions.h"
+#include "../l0/MEP.h"
+#include "../l0/MEPFragment.h"
+#include "../l0/Subevent.h"
 #include "../options/Logging.h"
+#include "../utils/NumaTopology.h"
 
 #include "Event.h"
+#include "EventArena.h"
+#include "EventTimeoutHandler.h"
+#include "SourceIDManager.h"
+#include "UnfinishedEventsCollector.h"
 
 namespace na62 {
 
-std::vector<Event*> EventPool::events_;
+std::atomic<Event*>* EventPool::events_ = nullptr;
 uint_fast32_t EventPool::poolSize_;
-uint_fast32_t EventPool::largestIndexTouched_;
+std::atomic<uint_fast32_t> EventPool::largestIndexTouched_(0);
+std::atomic<uint8_t>* EventPool::eventStates_ = nullptr;
+std::atomic<uint_fast64_t> EventPool::lastSweepDuration_(0);
 uint_fast32_t EventPool::mepFactor_;
 uint_fast32_t EventPool::mepFactorxNodeID_;
 uint_fast32_t EventPool::mepFactorxNodes_;
+uint_fast32_t EventPool::numberOfPartitions_ = 1;
+uint_fast32_t EventPool::partitionBlockSize_ = 1;
+std::atomic<uint_fast32_t> EventPool::numberOfRetiredEvents_(0);
+std::vector<Event*> EventPool::unreachableEvents_;
+std::atomic<Event*>* EventPool::retiredEventsByIndex_ = nullptr;
 
 std::atomic<uint16_t>* EventPool::L0PacketCounter_;
 std::atomic<uint16_t>* EventPool::L1PacketCounter_;
 
-void EventPool::initialize(uint numberOfEventsToBeStored, uint numberOfNodes, uint logicalNodeID, uint mepFactor) {
+void EventPool::initialize(uint numberOfEventsToBeStored, uint numberOfNodes, uint logicalNodeID, uint mepFactor,
+		bool partitionByNumaNode) {
 	poolSize_ = numberOfEventsToBeStored;
-	events_.resize(poolSize_);
 
     mepFactor_ = mepFactor;
     mepFactorxNodes_ = mepFactor_ * numberOfNodes;
     mepFactorxNodeID_ = mepFactor_ * logicalNodeID;
 
-	LOG_INFO("Initializing EventPool with " << poolSize_
-	<< " Events");
+	numberOfPartitions_ = 1;
+	partitionBlockSize_ = mepFactor_ > 0 ? mepFactor_ : 1;
+	if (partitionByNumaNode) {
+		NumaTopology::initialize();
+		numberOfPartitions_ = NumaTopology::getNumberOfNodes();
+	}
 
-	/*
-	 * Fill the pool with empty events.
-	 */
+	events_ = new std::atomic<Event*>[poolSize_];
+	eventStates_ = new std::atomic<uint8_t>[poolSize_];
+	retiredEventsByIndex_ = new std::atomic<Event*>[poolSize_];
+	for (uint_fast32_t i = 0; i != poolSize_; ++i) {
+		events_[i].store(nullptr, std::memory_order_relaxed);
+		eventStates_[i].store((uint8_t) EventState::FREE, std::memory_order_relaxed);
+		retiredEventsByIndex_[i].store(nullptr, std::memory_order_relaxed);
+	}
 
-#ifdef HAVE_TCMALLOC
-        // Do it with parallel_for using tbb if tcmalloc is linked
-        tbb::parallel_for(
-                        tbb::blocked_range<uint_fast32_t>(0, poolSize_,
-                                        poolSize_
-                                                        / std::thread::hardware_concurrency()),
-                        [](const tbb::blocked_range<uint_fast32_t>& r) {
-                                for(size_t i=r.begin();i!=r.end(); ++i) {
-                                        uint_fast32_t evID = (i - (floor(i / mepFactor_) * mepFactor_)) + (mepFactorxNodeID_ + (mepFactorxNodes_ * floor(i / mepFactor_)));
-                                        events_[i] = new Event(evID);
-                                }
-                        });
-# else
-        // The standard malloc blocks-> do it singlethreaded without tcmalloc
-        for (uint_fast32_t i = 0; i != poolSize_; ++i) {
-        	uint_fast32_t evID = (i - floor(i / mepFactor_) * mepFactor_) + (mepFactorxNodeID_ + (mepFactorxNodes_ * floor(i / mepFactor_)));
-        	events_[i] = new Event(evID);
-        }
-#endif
+	LOG_INFO("Initializing EventPool with " << poolSize_
+	<< " Events in " << numberOfPartitions_ << " partition(s)");
 
+	createEvents();
 
 	L0PacketCounter_= new std::atomic<uint16_t>[poolSize_];
 	L1PacketCounter_= new std::atomic<uint16_t>[poolSize_];
@@ -97,17 +112,518 @@ Event* EventPool::getEvent(uint_fast32_t eventNumber) {
             }
 
 
-    if(index>largestIndexTouched_){
-            largestIndexTouched_ = index;
-    }
+    updateLargestIndexTouched(index);
+
+    return events_[index].load(std::memory_order_acquire);
 
-    return events_[index];
+}
 
+Event* EventPool::getEventForL1Fragment(uint_fast32_t eventNumber) {
+	Event* event = getEvent(eventNumber);
+	if (event == nullptr || event->isL1Processed()) {
+		return event;
+	}
+	Event* retiredEvent = retiredEventsByIndex_[event->getPoolIndex()].load(std::memory_order_acquire);
+	if (retiredEvent != nullptr && retiredEvent->isL1Processed()) {
+		return retiredEvent;
+	}
+	return event;
+}
+
+/*
+ * Number of fragments addL0MEP looks ahead to prefetch subevents. Events are prefetched twice as far ahead
+ */
+static const uint_fast16_t L0MEPPrefetchDistance = 4;
+
+uint_fast16_t EventPool::addL0MEP(l0::MEP* mep, uint_fast32_t burstID,
+		Event** completedEvents) {
+	const uint_fast16_t numberOfFragments = mep->getNumberOfFragments();
+	const uint_fast32_t firstEventNum = mep->getFirstEventNum();
+	const uint_fast8_t sourceIDNum = mep->getSourceIDNum();
+	uint_fast16_t numberOfCompletedEvents = 0;
+	if (numberOfFragments == 0) {
+		return 0;
+	}
+
+	/*
+	 * The events are stored consecutively in events_ as long as they are within the same block of
+	 * mepFactor_ event numbers assigned to this node
+	 */
+	const uint_fast32_t positionInBlock = (firstEventNum - mepFactorxNodeID_)
+			% mepFactorxNodes_;
+	const uint_fast32_t firstIndex = firstEventNum - mepFactorxNodeID_
+			+ (mepFactor_ - mepFactorxNodes_) * (firstEventNum / mepFactorxNodes_);
+
+	if (positionInBlock + numberOfFragments > mepFactor_
+			|| firstIndex + numberOfFragments > poolSize_) {
+		/*
+		 * Not all events belong to this node or the pool: Check every fragment separately
+		 */
+		for (uint_fast16_t i = 0; i != numberOfFragments; i++) {
+			l0::MEPFragment* fragment = mep->getFragment(i);
+			Event* event = getEvent(fragment->getEventNumber());
+			if (event == nullptr) {
+				fragment->release();
+			} else if (event->addL0Fragment(fragment, burstID)) {
+				completedEvents[numberOfCompletedEvents++] = event;
+			}
+		}
+		return numberOfCompletedEvents;
+	}
+
+	updateLargestIndexTouched(firstIndex + numberOfFragments - 1);
+
+	/*
+	 * The slots are never empty but may be replaced by switchSourceLayout at any time
+	 */
+	std::atomic<Event*>* events = &events_[firstIndex];
+	for (uint_fast16_t i = 0; i != numberOfFragments; i++) {
+		if (i + 2 * L0MEPPrefetchDistance < numberOfFragments) {
+			__builtin_prefetch(events[i + 2 * L0MEPPrefetchDistance].load(std::memory_order_relaxed), 1);
+		}
+		if (i + L0MEPPrefetchDistance < numberOfFragments) {
+			/*
+			 * The event may still be built for a previous layout with less sources
+			 */
+			const Event* event = events[i + L0MEPPrefetchDistance].load(std::memory_order_relaxed);
+			if (sourceIDNum < event->getSourceLayout()->numberOfL0Sources) {
+				__builtin_prefetch(event->getL0SubeventBySourceIDNum(sourceIDNum), 1);
+			}
+		}
+
+		/*
+		 * Don't touch the MEP after adding its last fragment: it might have been deleted by another thread
+		 */
+		Event* event = events[i].load(std::memory_order_acquire);
+		if (event->addL0Fragment(mep->getFragment(i), burstID)) {
+			completedEvents[numberOfCompletedEvents++] = event;
+		}
+	}
+	return numberOfCompletedEvents;
 }
 
 void EventPool::freeEvent(Event* event) {
 	event->destroy();
 }
 
+/*
+ * Returns the first index in [from, to) with minState <= state <= maxState
+ */
+static uint_fast32_t findNextIndexInStateRange(const std::atomic<uint8_t>* eventStates,
+		uint_fast32_t from, const uint_fast32_t to, const EventState minState,
+		const EventState maxState) {
+	/*
+	 * std::atomic<uint8_t> has the same layout as uint8_t. The result is a snapshot anyway
+	 */
+	const uint8_t* states = reinterpret_cast<const uint8_t*>(eventStates);
+	const uint8_t min = (uint8_t) minState;
+	const uint8_t range = (uint8_t) maxState - min;
+
+#ifdef __SSE2__
+	const __m128i minVector = _mm_set1_epi8(min);
+	const __m128i rangeVector = _mm_set1_epi8(range);
+	while (from + sizeof(__m128i) <= to) {
+		/*
+		 * state - min <= range (unsigned) <=> min(state - min, range) == state - min
+		 */
+		const __m128i offsets = _mm_sub_epi8(
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(states + from)), minVector);
+		const int mask = _mm_movemask_epi8(
+				_mm_cmpeq_epi8(_mm_min_epu8(offsets, rangeVector), offsets));
+		if (mask != 0) {
+			return from + __builtin_ctz(mask);
+		}
+		from += sizeof(__m128i);
+	}
+#endif
+	for (; from < to; ++from) {
+		if ((uint8_t) (states[from] - min) <= range) {
+			return from;
+		}
+	}
+	return to;
+}
+
+/*
+ * Statistics collected by every thread during sweepUnfinishedEvents
+ */
+struct SweepStatistics {
+	std::vector<uint64_t> missingL0EventsBySourceNum;
+	std::vector<uint64_t> missingL1EventsBySourceNum;
+	std::map<uint, std::map<uint, uint>> receivedSubSourceIDsBySourceNum;
+	uint_fast32_t freedEvents;
+
+	SweepStatistics() :
+			missingL0EventsBySourceNum(SourceIDManager::NUMBER_OF_L0_DATA_SOURCES, 0), missingL1EventsBySourceNum(
+					SourceIDManager::NUMBER_OF_L1_DATA_SOURCES, 0), freedEvents(0) {
+	}
+};
+
+/*
+ * Number of pool indices processed by one task of the sweep
+ */
+static const uint_fast32_t SweepChunkSize = 16384;
+
+uint_fast32_t EventPool::sweepUnfinishedEvents(const uint_fast32_t currentBurstID) {
+	boost::timer::cpu_timer sweepTimer;
+
+	const uint_fast32_t end = std::min(getLargestTouchedEventnumberIndex() + 1, poolSize_);
+	tbb::enumerable_thread_specific<SweepStatistics> statisticsByThread;
+
+	tbb::parallel_for(tbb::blocked_range<uint_fast32_t>(0, end, SweepChunkSize),
+			[&statisticsByThread, currentBurstID](const tbb::blocked_range<uint_fast32_t>& r) {
+				SweepStatistics& statistics = statisticsByThread.local();
+				for (uint_fast32_t index = findNextLiveIndex(r.begin(), r.end()); index != r.end();
+						index = findNextLiveIndex(index + 1, r.end())) {
+					Event* event = events_[index].load(std::memory_order_acquire);
+					if (event->sweep(currentBurstID, statistics.missingL0EventsBySourceNum.data(),
+							statistics.missingL1EventsBySourceNum.data(),
+							statistics.receivedSubSourceIDsBySourceNum)) {
+						statistics.freedEvents++;
+					}
+				}
+			});
+
+	uint_fast32_t freedEvents = 0;
+	for (const SweepStatistics& statistics : statisticsByThread) {
+		Event::addMissingEventsStats(statistics.missingL0EventsBySourceNum.data(),
+				statistics.missingL1EventsBySourceNum.data());
+		UnfinishedEventsCollector::addReceivedSubSourceIds(
+				statistics.receivedSubSourceIDsBySourceNum);
+		freedEvents += statistics.freedEvents;
+	}
+
+	lastSweepDuration_ = sweepTimer.elapsed().wall / 1000;
+	LOG_INFO("Freed " << freedEvents << " unfinished events of " << end << " pool entries in "
+			<< lastSweepDuration_ << " us using " << statisticsByThread.size() << " thread(s)");
+	return freedEvents;
+}
+
+/*
+ * Creates the event at <index> either on the heap or in its slot of the EventArena
+ */
+static inline Event* createEvent(const uint_fast32_t eventNumber, const uint_fast32_t index) {
+	if (EventArena::isAllocated()) {
+		return ::new (EventArena::getStorage(index)) Event(eventNumber, index);
+	}
+	return new Event(eventNumber, index);
+}
+
+void EventPool::createEvents() {
+	if (EventArena::isEnabled()) {
+		if (Event::isUsingContiguousStorage()) {
+			EventArena::allocate(poolSize_, Event::getContiguousStorageSize(), numberOfPartitions_,
+					partitionBlockSize_);
+		} else {
+			LOG_WARNING("The event arena can only be used with contiguous event storage");
+		}
+	}
+
+	/*
+	 * Fill the pool with empty events.
+	 */
+	if (numberOfPartitions_ > 1) {
+		/*
+		 * Allocate the events of every partition on its own node (first touch)
+		 */
+		std::vector<std::thread> threads;
+		for (uint_fast32_t node = 0; node != numberOfPartitions_; ++node) {
+			threads.push_back(std::thread([node]() {
+				NumaTopology::runOnNode(node, [node]() {
+					for (uint_fast32_t i = node * partitionBlockSize_; i < poolSize_;
+							i += numberOfPartitions_ * partitionBlockSize_) {
+						const uint_fast32_t blockEnd = std::min(i + partitionBlockSize_, poolSize_);
+						for (uint_fast32_t index = i; index != blockEnd; ++index) {
+							installEvent(index);
+						}
+					}
+				});
+			}));
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+	} else if (EventArena::isAllocated()) {
+		// No malloc involved: always use all cores
+		tbb::parallel_for(tbb::blocked_range<uint_fast32_t>(0, poolSize_, SweepChunkSize),
+				[](const tbb::blocked_range<uint_fast32_t>& r) {
+					for (uint_fast32_t i = r.begin(); i != r.end(); ++i) {
+						installEvent(i);
+					}
+				});
+	} else {
+#ifdef HAVE_TCMALLOC
+        // Do it with parallel_for using tbb if tcmalloc is linked
+        tbb::parallel_for(
+                        tbb::blocked_range<uint_fast32_t>(0, poolSize_,
+                                        poolSize_
+                                                        / std::thread::hardware_concurrency()),
+                        [](const tbb::blocked_range<uint_fast32_t>& r) {
+                                for(size_t i=r.begin();i!=r.end(); ++i) {
+                                        installEvent(i);
+                                }
+                        });
+# else
+        // The standard malloc blocks-> do it singlethreaded without tcmalloc
+        for (uint_fast32_t i = 0; i != poolSize_; ++i) {
+        	installEvent(i);
+        }
+#endif
+	}
+}
+
+void EventPool::installEvent(const uint_fast32_t index) {
+	Event* event = createEvent(indexToEventNumber(index), index);
+	Event* previousEvent = events_[index].load(std::memory_order_relaxed);
+	if (previousEvent != nullptr) {
+		/*
+		 * The previous event stops updating the state of the index before the new one takes it over
+		 */
+		previousEvent->retire();
+		eventStates_[index].store((uint8_t) EventState::FREE, std::memory_order_relaxed);
+		L0PacketCounter_[index].store(0, std::memory_order_relaxed);
+		L1PacketCounter_[index].store(0, std::memory_order_relaxed);
+		retiredEventsByIndex_[index].store(previousEvent, std::memory_order_release);
+		numberOfRetiredEvents_.fetch_add(1, std::memory_order_relaxed);
+	}
+	events_[index].store(event, std::memory_order_release);
+}
+
+void EventPool::deleteEvents() {
+	/*
+	 * Deleting is not slowed down by a blocking malloc as much as creating: always use all cores
+	 */
+	tbb::parallel_for(tbb::blocked_range<uint_fast32_t>(0, poolSize_, SweepChunkSize),
+			[](const tbb::blocked_range<uint_fast32_t>& r) {
+				for (uint_fast32_t index = r.begin(); index != r.end(); ++index) {
+					Event* event = events_[index].exchange(nullptr, std::memory_order_relaxed);
+					if (EventArena::isAllocated()) {
+						event->~Event();
+					} else {
+						delete event;
+					}
+				}
+			});
+}
+
+void EventPool::freeAllEvents() {
+	const uint_fast32_t end = std::min(getLargestTouchedEventnumberIndex() + 1, poolSize_);
+	tbb::parallel_for(tbb::blocked_range<uint_fast32_t>(0, end, SweepChunkSize),
+			[](const tbb::blocked_range<uint_fast32_t>& r) {
+				for (uint_fast32_t index = findNextUsedIndex(r.begin(), r.end()); index != r.end();
+						index = findNextUsedIndex(index + 1, r.end())) {
+					freeEvent(events_[index].load(std::memory_order_relaxed));
+				}
+			});
+	resetEventStates();
+}
+
+void EventPool::resetEventStates() {
+	for (uint_fast32_t i = 0; i != poolSize_; ++i) {
+		eventStates_[i].store((uint8_t) EventState::FREE, std::memory_order_relaxed);
+		L0PacketCounter_[i].store(0, std::memory_order_relaxed);
+		L1PacketCounter_[i].store(0, std::memory_order_relaxed);
+	}
+	largestIndexTouched_ = 0;
+}
+
+void EventPool::reclaimRetiredEvents() {
+	/*
+	 * Nobody has been able to look up these events for a whole burst: only threads still owning or pinning
+	 * them may access them
+	 */
+	std::vector<Event*> referencedEvents;
+	for (Event* event : unreachableEvents_) {
+		/*
+		 * A thread may have fetched the event from its slot right before it has been replaced
+		 */
+		if (event->isUnfinished()) {
+			freeEvent(event);
+		}
+		if (event->isUnreferenced()) {
+			delete event;
+		} else {
+			referencedEvents.push_back(event);
+		}
+	}
+	unreachableEvents_.swap(referencedEvents);
+
+	uint_fast32_t unfinishedEvents = 0;
+	if (numberOfRetiredEvents_.exchange(0, std::memory_order_relaxed) != 0) {
+		for (uint_fast32_t index = 0; index != poolSize_; ++index) {
+			Event* event = retiredEventsByIndex_[index].exchange(nullptr, std::memory_order_acq_rel);
+			if (event == nullptr) {
+				continue;
+			}
+			if (event->isUnfinished()) {
+				freeEvent(event);
+				unfinishedEvents++;
+			}
+			unreachableEvents_.push_back(event);
+		}
+	}
+
+	if (unfinishedEvents != 0 || !unreachableEvents_.empty()) {
+		LOG_INFO("Freed " << unfinishedEvents << " unfinished retired events. " << unreachableEvents_.size()
+				<< " retired events are waiting to be deleted");
+	}
+}
+
+void EventPool::deleteRetiredEvents() {
+	if (numberOfRetiredEvents_.exchange(0, std::memory_order_relaxed) != 0) {
+		for (uint_fast32_t index = 0; index != poolSize_; ++index) {
+			delete retiredEventsByIndex_[index].exchange(nullptr, std::memory_order_relaxed);
+		}
+	}
+	for (Event* event : unreachableEvents_) {
+		delete event;
+	}
+	unreachableEvents_.clear();
+}
+
+bool EventPool::reconfigure(const uint_fast16_t timeStampSourceID,
+		std::vector<std::pair<int, int> > l0SourceIDs,
+		std::vector<std::pair<int, int> > l1SourceIDs) {
+	boost::timer::cpu_timer reconfigureTimer;
+
+	EventTimeoutHandler::pause();
+	freeAllEvents();
+	deleteRetiredEvents();
+
+	const SourceLayout* previousLayout = SourceIDManager::getLayout();
+	previousLayout->acquire();
+	SourceIDManager::Initialize(timeStampSourceID, l0SourceIDs, l1SourceIDs);
+	Event::reinitialize();
+
+	const bool reuseEvents = SourceIDManager::getLayout()->hasSameShape(*previousLayout);
+	previousLayout->release();
+
+	if (reuseEvents) {
+		tbb::parallel_for(tbb::blocked_range<uint_fast32_t>(0, poolSize_, SweepChunkSize),
+				[](const tbb::blocked_range<uint_fast32_t>& r) {
+					for (uint_fast32_t index = r.begin(); index != r.end(); ++index) {
+						events_[index].load(std::memory_order_relaxed)->reassignSourceIDs();
+					}
+				});
+	} else {
+		deleteEvents();
+		createEvents();
+	}
+	EventTimeoutHandler::resume();
+
+	LOG_INFO((reuseEvents ? "Reused" : "Rebuilt") << " all " << poolSize_ << " events of the EventPool for the new source layout in "
+			<< reconfigureTimer.elapsed().wall / 1000000 << " ms");
+	return reuseEvents;
+}
+
+bool EventPool::switchSourceLayout() {
+	reclaimRetiredEvents();
+
+	/*
+	 * The wheel must neither see the global layout tables change while counting missing fragments nor expire
+	 * an event being detached or deleted
+	 */
+	EventTimeoutHandler::pause();
+	const SourceLayout* previousLayout = SourceIDManager::getLayout();
+	previousLayout->acquire();
+	/*
+	 * The arena slots can't be replaced while receivers may hold pointers to them. A layout of a different
+	 * shape stays pending until EventPool::reconfigure
+	 */
+	if (!SourceIDManager::switchToPendingLayout(EventArena::isAllocated())) {
+		if (SourceIDManager::hasPendingLayout()) {
+			LOG_WARNING("The event arena can't be switched to a source layout of a different shape. "
+					"It stays pending until the EventPool is reconfigured");
+		}
+		previousLayout->release();
+		EventTimeoutHandler::resume();
+		return false;
+	}
+	boost::timer::cpu_timer switchTimer;
+	Event::reinitialize();
+
+	const bool reuseEvents = SourceIDManager::getLayout()->hasSameShape(*previousLayout);
+	previousLayout->release();
+	if (events_ == nullptr) {
+		EventTimeoutHandler::resume();
+		return true;
+	}
+
+	/*
+	 * The receivers keep running: every slot is updated on its own and nothing in use is touched
+	 */
+	std::atomic<uint_fast32_t> eventsInUse(0);
+	if (reuseEvents) {
+		/*
+		 * Free events are bound to the new layout right away, the ones in use as soon as they are freed
+		 */
+		tbb::parallel_for(tbb::blocked_range<uint_fast32_t>(0, poolSize_, SweepChunkSize),
+				[&eventsInUse](const tbb::blocked_range<uint_fast32_t>& r) {
+					uint_fast32_t eventsInUseInRange = 0;
+					for (uint_fast32_t index = r.begin(); index != r.end(); ++index) {
+						if (!events_[index].load(std::memory_order_relaxed)->moveToCurrentLayout()) {
+							eventsInUseInRange++;
+						}
+					}
+					eventsInUse.fetch_add(eventsInUseInRange, std::memory_order_relaxed);
+				});
+	} else {
+		/*
+		 * Every slot gets a new event. The previous ones are deleted by reclaimRetiredEvents once no thread
+		 * can still be using them
+		 */
+		createEvents();
+	}
+	EventTimeoutHandler::resume();
+
+	if (reuseEvents) {
+		LOG_INFO("Reused the EventPool for source layout version " << SourceIDManager::getLayout()->version
+				<< " in " << switchTimer.elapsed().wall / 1000000 << " ms. " << eventsInUse.load()
+				<< " events in use will be moved to it when freed");
+	} else {
+		LOG_INFO("Rebuilt the EventPool for source layout version " << SourceIDManager::getLayout()->version
+				<< " in " << switchTimer.elapsed().wall / 1000000 << " ms. The previous events have been retired");
+	}
+	return true;
+}
+
+void EventPool::destroy() {
+	deleteEvents();
+	deleteRetiredEvents();
+	EventArena::release();
+	delete[] events_;
+	events_ = nullptr;
+	delete[] eventStates_;
+	delete[] retiredEventsByIndex_;
+	delete[] L0PacketCounter_;
+	delete[] L1PacketCounter_;
+	eventStates_ = nullptr;
+	retiredEventsByIndex_ = nullptr;
+	L0PacketCounter_ = nullptr;
+	L1PacketCounter_ = nullptr;
+	poolSize_ = 0;
+	largestIndexTouched_ = 0;
+}
+
+uint_fast32_t EventPool::findNextLiveIndex(uint_fast32_t from, uint_fast32_t to) {
+	return findNextIndexInStateRange(eventStates_, from, std::min(to, poolSize_),
+			EventState::BUILDING_L0, EventState::BUILDING_L1);
+}
+
+uint_fast32_t EventPool::findNextUsedIndex(uint_fast32_t from, uint_fast32_t to) {
+	return findNextIndexInStateRange(eventStates_, from, std::min(to, poolSize_),
+			EventState::BUILDING_L0, EventState::DONE);
+}
+
+void EventPool::countEventsByState(uint64_t* eventsByState) {
+	const uint_fast32_t end = std::min(getLargestTouchedEventnumberIndex() + 1, poolSize_);
+	for (uint_fast32_t i = 0; i < end; ++i) {
+		const uint8_t state = eventStates_[i].load(std::memory_order_relaxed);
+		if (state < (uint8_t) EventState::NUMBER_OF_STATES) {
+			eventsByState[state]++;
+		}
+	}
+}
+
 }
 /* namespace na62 */
@@ -10,14 +10,35 @@
 
 #include <sys/types.h>
 #include <cstdint>
+#include <utility>
 #include <vector>
 #include <atomic>
 
 namespace na62 {
+namespace l0 {
+class MEP;
+} /* namespace l0 */
+
+/*
+ * Life cycle of an event as stored in the state array of the EventPool
+ */
+enum class EventState : uint8_t {
+	FREE = 0, // Not used or destroyed
+	BUILDING_L0, // At least one L0 fragment received
+	WAITING_L1, // All L0 fragments received, L1 trigger not yet processed
+	BUILDING_L1, // L1 processed, waiting for L1 fragments and L2
+	DONE, // L2 processed, waiting to be destroyed
+	NUMBER_OF_STATES
+};
+
 class Event;
 class EventPool {
 private:
-	static std::vector<Event*> events_;
+	/*
+	 * One event per pool index. A slot is never empty but its event may be replaced at any time by
+	 * switchSourceLayout
+	 */
+	static std::atomic<Event*>* events_;
 	static uint_fast32_t poolSize_;
     static uint_fast32_t mepFactor_;
      static uint_fast32_t mepFactorxNodeID_;
@@ -29,23 +50,251 @@ private:
 	/*
 	 * Largest eventnumber that was passed to GetEvent
 	 */
-	static uint_fast32_t largestIndexTouched_;
+	static std::atomic<uint_fast32_t> largestIndexTouched_;
+
+	/*
+	 * One EventState per pool index
+	 */
+	static std::atomic<uint8_t>* eventStates_;
+
+	static std::atomic<uint_fast64_t> lastSweepDuration_;
+
+	/*
+	 * Retired events no longer reachable via retiredEventsByIndex_. They are deleted at a following switch as
+	 * soon as they are unreferenced (see Event::isUnreferenced)
+	 */
+	static std::vector<Event*> unreachableEvents_;
+
+	/*
+	 * One entry per pool index: the event replaced at the last switch or nullptr
+	 */
+	static std::atomic<Event*>* retiredEventsByIndex_;
+	static std::atomic<uint_fast32_t> numberOfRetiredEvents_;
+
+	/*
+	 * Number of NUMA partitions the index space is split into (1 if not partitioned)
+	 */
+	static uint_fast32_t numberOfPartitions_;
+	static uint_fast32_t partitionBlockSize_;
+
+	static inline void updateLargestIndexTouched(const uint_fast32_t index) {
+		uint_fast32_t largestIndex = largestIndexTouched_.load(std::memory_order_relaxed);
+		while (index > largestIndex
+				&& !largestIndexTouched_.compare_exchange_weak(largestIndex, index,
+						std::memory_order_relaxed)) {
+		}
+	}
+
+	/*
+	 * Creates all events. Every event is allocated by a thread running on the NUMA node owning it. If the
+	 * EventArena is enabled the events are stored in its prefaulted regions instead of the heap
+	 */
+	static void createEvents();
+
+	/*
+	 * Stores a new event at the given index. An event already stored there is retired (see
+	 * Event::retire) and moved to retiredEventsByIndex_
+	 */
+	static void installEvent(const uint_fast32_t index);
+
+	/*
+	 * Deletes all events in parallel without logging
+	 */
+	static void deleteEvents();
+
+	/*
+	 * Frees all used events without counting their missing fragments and resets the state of every index
+	 */
+	static void freeAllEvents();
+
+	/*
+	 * Sets every index FREE and resets the packet counters
+	 */
+	static void resetEventStates();
+
+	/*
+	 * Deletes the unreachable events that are unreferenced and makes the events retired at the last switch
+	 * unreachable. The unfinished ones are freed before without counting their missing fragments
+	 */
+	static void reclaimRetiredEvents();
+
+	/*
+	 * Deletes all retired events. Only to be used while no thread accesses any event
+	 */
+	static void deleteRetiredEvents();
+
+	static inline uint_fast32_t indexToEventNumber(const uint_fast32_t index) {
+		return (index - (index / mepFactor_) * mepFactor_)
+				+ (mepFactorxNodeID_ + (mepFactorxNodes_ * (index / mepFactor_)));
+	}
 public:
-	static void initialize(uint numberOfEventsToBeStored, uint numberOfNodes=1, uint logicalNodeID=0, uint mepFactor=0);
+	/**
+	 * If <partitionByNumaNode> is set the pool indices are split into blocks of <mepFactor> events which are
+	 * assigned round robin to the NUMA nodes. Every Event is allocated by a thread running on the node owning it.
+	 */
+	static void initialize(uint numberOfEventsToBeStored, uint numberOfNodes=1, uint logicalNodeID=0, uint mepFactor=0,
+			bool partitionByNumaNode=false);
 	static Event* getEvent(uint_fast32_t eventNumber);
+
+	/**
+	 * Returns the event L1 fragments with the given event number have to be added to. This is the event
+	 * returned by getEvent unless the event at that index has been retired by the last switchSourceLayout
+	 * while waiting for its L1 fragments and the new event has not been processed by L1 yet
+	 */
+	static Event* getEventForL1Fragment(uint_fast32_t eventNumber);
+
+	/**
+	 * Initializes the SourceIDManager with the given layout (see SourceIDManager::Initialize) and adapts all
+	 * events to it without changing the pool size. All events are freed before without counting them as
+	 * missing.
+	 *
+	 * If the number of sources and the expected packets of every sourceNum did not change the existing events
+	 * are reused and only their sourceIDs are updated. Otherwise all events are deleted and created again in
+	 * parallel. Returns true if the events have been reused.
+	 *
+	 * Must only be called between runs while no thread accesses any event.
+	 */
+	static bool reconfigure(const uint_fast16_t timeStampSourceID,
+			std::vector<std::pair<int, int> > l0SourceIDs,
+			std::vector<std::pair<int, int> > l1SourceIDs);
+
+	/**
+	 * Publishes the source layout scheduled by SourceIDManager::scheduleLayout, if any, and moves the pool to
+	 * it. Called by the BurstIdHandler between two bursts while the receivers keep adding fragments.
+	 *
+	 * If the new layout has the same shape (see SourceLayout::hasSameShape) all events are reused: FREE events
+	 * are moved to it right away, events in use keep the layout they have been built with until they are freed.
+	 *
+	 * Otherwise every event is replaced by a new one. The replaced events keep their layout and can still be
+	 * completed: until the following switch they receive their L1 fragments (see getEventForL1Fragment) and
+	 * are processed by their owning threads. The following switch frees them if they are still unfinished and
+	 * deletes them once they have been unreachable for a whole burst and are unreferenced (see
+	 * Event::isUnreferenced). Events stored in the EventArena cannot be replaced: a layout of a different
+	 * shape stays scheduled until reconfigure is called.
+	 *
+	 * The EventTimeoutHandler is paused while the events are moved.
+	 *
+	 * Returns false if no layout has been published
+	 */
+	static bool switchSourceLayout();
+
+	/**
+	 * Deletes all events in parallel. The pool has to be initialized again before it can be used
+	 */
+	static void destroy();
+
+	/**
+	 * Adds all fragments of the given MEP to their events. This is equivalent to calling
+	 * getEvent(fragment->getEventNumber())->addL0Fragment(fragment, burstID) for every fragment but the node
+	 * ownership and the event index are only computed once per MEP.
+	 *
+	 * The events completed by this MEP are written to <completedEvents> which must be able to store
+	 * mep->getNumberOfFragments() pointers. Returns the number of completed events.
+	 *
+	 * Fragments that do not belong to any event of this node are deleted. The MEP must not be accessed
+	 * after calling this method as it may already be deleted.
+	 */
+	static uint_fast16_t addL0MEP(l0::MEP* mep, uint_fast32_t burstID,
+			Event** completedEvents);
     static Event* getEventByIndex(uint_fast32_t index){
             if (index>=poolSize_) return nullptr;
-            return events_[index];
+            return events_[index].load(std::memory_order_acquire);
     }
 
+	/**
+	 * Destroys the event. If the event is pinned (see Event::pin) it is destroyed by the last Event::unpin()
+	 */
     static void freeEvent(Event* event);
 
+	/**
+	 * Frees all unfinished events up to getLargestTouchedEventnumberIndex() that do not belong to the burst
+	 * <currentBurstID>, whose fragments may already be arriving. Every event is claimed before being read
+	 * (see Event::sweep), pinned events are left alone. Before being freed the missing fragments of every
+	 * event are counted (see Event::updateMissingEventsStats) and the received subIDs are passed to the
+	 * UnfinishedEventsCollector.
+	 *
+	 * The work is split into chunks processed by TBB workers collecting their statistics separately. The
+	 * statistics are merged at the end. Returns the number of freed events.
+	 */
+	static uint_fast32_t sweepUnfinishedEvents(const uint_fast32_t currentBurstID);
+
+	/*
+	 * Wall time in microseconds used by the last call of sweepUnfinishedEvents
+	 */
+	static uint_fast64_t getLastSweepDuration() {
+		return lastSweepDuration_;
+	}
+
 	static uint_fast32_t getLargestTouchedEventnumberIndex(){
-		return largestIndexTouched_;
+		return largestIndexTouched_.load(std::memory_order_relaxed);
 	}
+
+	static inline EventState getEventState(const uint_fast32_t index) {
+		return (EventState) eventStates_[index].load(std::memory_order_acquire);
+	}
+
+	/*
+	 * DO NOT USE THIS METHOD IF YOUR ARE IMPLEMENTING TRIGGER ALGORITHMS
+	 */
+	static inline void setEventState(const uint_fast32_t index, const EventState state) {
+		if (index < poolSize_) {
+			eventStates_[index].store((uint8_t) state, std::memory_order_release);
+		}
+	}
+
+	/*
+	 * Sets the state of the event at <index> to <newState> only if it currently is <expectedState>
+	 */
+	static inline bool changeEventState(const uint_fast32_t index, EventState expectedState,
+			const EventState newState) {
+		if (index >= poolSize_) {
+			return false;
+		}
+		uint8_t expected = (uint8_t) expectedState;
+		return eventStates_[index].compare_exchange_strong(expected, (uint8_t) newState,
+				std::memory_order_acq_rel);
+	}
+
+	/**
+	 * Returns the smallest index within [from, to) of an event in BUILDING_L0, WAITING_L1 or BUILDING_L1 state.
+	 * Returns <to> if there is none. Only the state array is scanned, no Event is touched.
+	 */
+	static uint_fast32_t findNextLiveIndex(uint_fast32_t from, uint_fast32_t to);
+
+	/**
+	 * Same as findNextLiveIndex but also returns events in DONE state
+	 */
+	static uint_fast32_t findNextUsedIndex(uint_fast32_t from, uint_fast32_t to);
+
+	/**
+	 * Adds the number of events in every state within [0, getLargestTouchedEventnumberIndex()] to
+	 * <eventsByState> which must have (uint) EventState::NUMBER_OF_STATES entries
+	 */
+	static void countEventsByState(uint64_t* eventsByState);
 	static uint_fast32_t getPoolSize(){
 			return poolSize_;
 	}
+
+	static uint_fast32_t getNumberOfPartitions() {
+		return numberOfPartitions_;
+	}
+
+	/**
+	 * Returns the NUMA node owning the event at the given pool index. Always 0 if the pool is not partitioned
+	 */
+	static inline uint_fast32_t getNumaNodeOfIndex(const uint_fast32_t index) {
+		return (index / partitionBlockSize_) % numberOfPartitions_;
+	}
+
+	/**
+	 * Returns the NUMA node owning the event with the given event number. Receiver threads should run on this
+	 * node when adding fragments of this event. The event number must belong to this farm node.
+	 */
+	static inline uint_fast32_t getNumaNodeOfEventNumber(const uint_fast32_t eventNumber) {
+		return getNumaNodeOfIndex(
+				eventNumber - mepFactorxNodeID_
+						+ (mepFactor_ - mepFactorxNodes_) * (eventNumber / mepFactorxNodes_));
+	}
 	static std::atomic<uint16_t>* getL0PacketCounter(){
 		return L0PacketCounter_;
 	}
@@ -0,0 +1,180 @@
+/*
+ * EventTimeoutHandler.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "EventTimeoutHandler.h"
+
+#include <boost/timer/timer.hpp>
+#include <map>
+#include <vector>
+
+#include "../options/Logging.h"
+#include "Event.h"
+#include "EventPool.h"
+#include "SourceIDManager.h"
+#include "UnfinishedEventsCollector.h"
+
+namespace na62 {
+
+std::atomic<bool> EventTimeoutHandler::running_(false);
+std::mutex EventTimeoutHandler::wheelMutex_;
+uint_fast32_t EventTimeoutHandler::poolSize_ = 0;
+uint EventTimeoutHandler::tickMillis_ = 1;
+uint_fast32_t EventTimeoutHandler::l0TimeoutTicks_ = 0;
+uint_fast32_t EventTimeoutHandler::l1TimeoutTicks_ = 0;
+
+std::atomic<uint_fast32_t> EventTimeoutHandler::currentTick_(0);
+uint_fast32_t EventTimeoutHandler::slotMask_ = 0;
+std::atomic<uint32_t>* EventTimeoutHandler::slotHeads_ = nullptr;
+
+std::atomic<uint32_t>* EventTimeoutHandler::nextIndices_ = nullptr;
+std::atomic<uint32_t>* EventTimeoutHandler::arrivalTicks_ = nullptr;
+std::atomic<uint8_t>* EventTimeoutHandler::linked_ = nullptr;
+
+std::atomic<uint64_t> EventTimeoutHandler::expiredL0Events_(0);
+std::atomic<uint64_t> EventTimeoutHandler::expiredL1Events_(0);
+
+/*
+ * Statistics of the events expired during one tick
+ */
+static std::vector<uint64_t> missingL0EventsBySourceNum;
+static std::vector<uint64_t> missingL1EventsBySourceNum;
+static std::map<uint, std::map<uint, uint>> receivedSubSourceIDsBySourceNum;
+
+/*
+ * Ticks are compared modulo 2^32
+ */
+static inline bool isReached(const uint_fast32_t deadlineTick, const uint_fast32_t tick) {
+	return (int32_t) (uint32_t) (tick - deadlineTick) >= 0;
+}
+
+void EventTimeoutHandler::initialize(uint l0TimeoutMillis, uint l1TimeoutMillis, uint tickMillis) {
+	tickMillis_ = tickMillis > 0 ? tickMillis : 1;
+	l0TimeoutTicks_ = std::max(1u, l0TimeoutMillis / tickMillis_);
+	l1TimeoutTicks_ = std::max(1u, l1TimeoutMillis / tickMillis_);
+
+	/*
+	 * All deadlines are less than one revolution ahead
+	 */
+	uint_fast32_t numberOfSlots = 2;
+	while (numberOfSlots <= std::max(l0TimeoutTicks_, l1TimeoutTicks_) + 1) {
+		numberOfSlots <<= 1;
+	}
+	slotMask_ = numberOfSlots - 1;
+	slotHeads_ = new std::atomic<uint32_t>[numberOfSlots];
+	for (uint_fast32_t slot = 0; slot != numberOfSlots; slot++) {
+		slotHeads_[slot] = EmptySlot;
+	}
+
+	poolSize_ = EventPool::getPoolSize();
+	nextIndices_ = new std::atomic<uint32_t>[poolSize_];
+	arrivalTicks_ = new std::atomic<uint32_t>[poolSize_];
+	linked_ = new std::atomic<uint8_t>[poolSize_];
+	for (uint_fast32_t index = 0; index != poolSize_; index++) {
+		nextIndices_[index] = EmptySlot;
+		arrivalTicks_[index] = 0;
+		linked_[index] = 0;
+	}
+
+	// The source layout may grow between two bursts (see SourceIDManager::scheduleLayout)
+	missingL0EventsBySourceNum.assign(256, 0);
+	missingL1EventsBySourceNum.assign(256, 0);
+
+	currentTick_ = 0;
+	running_ = true;
+	LOG_INFO("Expiring incomplete events after " << l0TimeoutTicks_ * tickMillis_ << " ms (L0) and " << l1TimeoutTicks_ * tickMillis_ << " ms (L1) using " << numberOfSlots << " slots of " << tickMillis_ << " ms");
+}
+
+uint_fast32_t EventTimeoutHandler::processSlot(const uint_fast32_t tick) {
+	uint32_t index = slotHeads_[tick & slotMask_].exchange(EmptySlot, std::memory_order_acquire);
+	uint_fast32_t expiredEvents = 0;
+
+	while (index != EmptySlot) {
+		const uint32_t next = nextIndices_[index].load(std::memory_order_relaxed);
+		const uint_fast32_t arrivalTick = arrivalTicks_[index].load(std::memory_order_relaxed);
+		const EventState state = EventPool::getEventState(index);
+
+		uint_fast32_t deadlineTick = 0;
+		bool keep = true;
+		switch (state) {
+		case EventState::BUILDING_L0:
+			deadlineTick = arrivalTick + l0TimeoutTicks_;
+			break;
+		case EventState::BUILDING_L1:
+			deadlineTick = arrivalTick + l1TimeoutTicks_;
+			break;
+		case EventState::WAITING_L1:
+			// The L1 trigger owns the event: look again later
+			deadlineTick = tick + l1TimeoutTicks_;
+			break;
+		default:
+			keep = false;
+			break;
+		}
+
+		if (keep && isReached(deadlineTick, tick)) {
+			Event* event = EventPool::getEventByIndex(index);
+			if (event->expire(state, missingL0EventsBySourceNum.data(),
+					missingL1EventsBySourceNum.data(), receivedSubSourceIDsBySourceNum)) {
+				(state == EventState::BUILDING_L0 ? expiredL0Events_ : expiredL1Events_).fetch_add(1,
+						std::memory_order_relaxed);
+				expiredEvents++;
+				keep = false;
+			} else {
+				// The event has changed in the meantime
+				deadlineTick = tick + 1;
+			}
+		}
+
+		if (keep) {
+			link(index, isReached(deadlineTick, tick) ? tick + 1 : deadlineTick);
+		} else {
+			linked_[index].store(0, std::memory_order_release);
+			/*
+			 * The event may have been reused while we were checking it: registerEvent() did not link it
+			 * as it was still linked here
+			 */
+			uint8_t linked = 0;
+			if (EventPool::getEventState(index) == EventState::BUILDING_L0
+					&& linked_[index].compare_exchange_strong(linked, 1, std::memory_order_acq_rel)) {
+				link(index, arrivalTicks_[index].load(std::memory_order_relaxed) + l0TimeoutTicks_);
+			}
+		}
+		index = next;
+	}
+	return expiredEvents;
+}
+
+void EventTimeoutHandler::thread() {
+	boost::timer::cpu_timer clock;
+	uint_fast32_t processedTick = 0;
+
+	while (running_) {
+		const uint_fast32_t tick = clock.elapsed().wall / (tickMillis_ * 1000000ULL);
+		currentTick_.store(tick, std::memory_order_relaxed);
+
+		{
+			std::lock_guard<std::mutex> lock(wheelMutex_);
+			uint_fast32_t expiredEvents = 0;
+			while (processedTick != tick) {
+				processedTick++;
+				expiredEvents += processSlot(processedTick);
+			}
+
+			if (expiredEvents != 0) {
+				Event::addMissingEventsStats(missingL0EventsBySourceNum.data(),
+						missingL1EventsBySourceNum.data());
+				UnfinishedEventsCollector::addReceivedSubSourceIds(receivedSubSourceIDsBySourceNum);
+				std::fill(missingL0EventsBySourceNum.begin(), missingL0EventsBySourceNum.end(), 0);
+				std::fill(missingL1EventsBySourceNum.begin(), missingL1EventsBySourceNum.end(), 0);
+				receivedSubSourceIDsBySourceNum.clear();
+			}
+		}
+
+		boost::this_thread::sleep(boost::posix_time::microsec(tickMillis_ * 1000));
+	}
+}
+
+} /* namespace na62 */
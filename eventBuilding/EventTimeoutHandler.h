@@ -0,0 +1,134 @@
+/*
+ * EventTimeoutHandler.h
+ *
+ * Timing wheel freeing incomplete events that are older than a configurable timeout instead of waiting for
+ * the end of the burst. Every event is registered with the tick of its first L0 fragment. The wheel thread
+ * advances a coarse tick clock and checks the events whose deadline has passed:
+ *
+ * BUILDING_L0: expired <l0TimeoutMillis> after the first fragment
+ * BUILDING_L1: expired <l1TimeoutMillis> after the first fragment
+ * WAITING_L1: owned by the L1 trigger, checked again later
+ * FREE, DONE: removed from the wheel
+ *
+ * The missing fragments of expired events are counted like in EventPool::sweepUnfinishedEvents.
+ *
+ * Every slot of the wheel is an intrusive lock-free list of pool indices: the next pointers are stored
+ * in an array with one entry per pool index so that registering an event never allocates memory.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef EVENTTIMEOUTHANDLER_H_
+#define EVENTTIMEOUTHANDLER_H_
+
+#include <sys/types.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "../utils/AExecutable.h"
+
+namespace na62 {
+
+class EventTimeoutHandler: public AExecutable {
+public:
+	/**
+	 * Must be called after EventPool::initialize. The thread has to be started via startThread()
+	 */
+	static void initialize(uint l0TimeoutMillis, uint l1TimeoutMillis, uint tickMillis = 1);
+
+	static void shutDown() {
+		running_ = false;
+	}
+
+	static inline bool isActive() {
+		return running_;
+	}
+
+	/**
+	 * Blocks the wheel until resume() is called. Returns as soon as the wheel has finished the tick it is
+	 * processing so that no event is expired while the EventPool replaces its events
+	 */
+	static void pause() {
+		wheelMutex_.lock();
+	}
+
+	static void resume() {
+		wheelMutex_.unlock();
+	}
+
+	/*
+	 * Called by the event building when the first L0 fragment of the event at <poolIndex> has been received
+	 */
+	static inline void registerEvent(const uint_fast32_t poolIndex) {
+		if (poolIndex >= poolSize_) {
+			return;
+		}
+		const uint_fast32_t tick = currentTick_.load(std::memory_order_relaxed);
+		arrivalTicks_[poolIndex].store(tick, std::memory_order_relaxed);
+
+		/*
+		 * An event reused before the wheel has removed it from its old slot is not linked again: the wheel
+		 * moves it to the right slot as soon as it sees the new arrival tick
+		 */
+		uint8_t linked = 0;
+		if (linked_[poolIndex].compare_exchange_strong(linked, 1, std::memory_order_acq_rel)) {
+			link(poolIndex, tick + l0TimeoutTicks_);
+		}
+	}
+
+	static inline uint64_t getExpiredL0Events() {
+		return expiredL0Events_.load(std::memory_order_relaxed);
+	}
+
+	static inline uint64_t getExpiredL1Events() {
+		return expiredL1Events_.load(std::memory_order_relaxed);
+	}
+
+	void thread();
+
+private:
+	static const uint32_t EmptySlot = UINT32_MAX;
+
+	static inline void link(const uint_fast32_t poolIndex, const uint_fast32_t deadlineTick) {
+		std::atomic<uint32_t>& head = slotHeads_[deadlineTick & slotMask_];
+		uint32_t next = head.load(std::memory_order_relaxed);
+		do {
+			nextIndices_[poolIndex].store(next, std::memory_order_relaxed);
+		} while (!head.compare_exchange_weak(next, poolIndex, std::memory_order_release,
+				std::memory_order_relaxed));
+	}
+
+	/*
+	 * Checks all events of the slot of <tick>. Returns the number of expired events
+	 */
+	static uint_fast32_t processSlot(const uint_fast32_t tick);
+
+	static std::atomic<bool> running_;
+	/*
+	 * Held by the wheel thread while processing the slots of a tick
+	 */
+	static std::mutex wheelMutex_;
+	static uint_fast32_t poolSize_;
+	static uint tickMillis_;
+	static uint_fast32_t l0TimeoutTicks_;
+	static uint_fast32_t l1TimeoutTicks_;
+
+	static std::atomic<uint_fast32_t> currentTick_;
+	static uint_fast32_t slotMask_;
+	static std::atomic<uint32_t>* slotHeads_;
+
+	/*
+	 * One entry per pool index
+	 */
+	static std::atomic<uint32_t>* nextIndices_;
+	static std::atomic<uint32_t>* arrivalTicks_;
+	static std::atomic<uint8_t>* linked_;
+
+	static std::atomic<uint64_t> expiredL0Events_;
+	static std::atomic<uint64_t> expiredL1Events_;
+};
+
+} /* namespace na62 */
+
+#endif /* EVENTTIMEOUTHANDLER_H_ */
@@ -0,0 +1,132 @@
+/*
+ * NonZSuppressedLkrFragmentTable.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "NonZSuppressedLkrFragmentTable.h"
+
+#include "../l1/MEPFragment.h"
+#include "../options/Logging.h"
+
+namespace na62 {
+
+uint_fast32_t NonZSuppressedLkrFragmentTable::tableCapacityBits_ = 10;
+BoundedMPMCQueue<NonZSuppressedLkrFragmentTable*>* NonZSuppressedLkrFragmentTable::pool_ =
+		nullptr;
+
+/*
+ * Maximum number of unused tables kept in the pool
+ */
+static const uint_fast32_t MaxPoolSize = 4096;
+
+void NonZSuppressedLkrFragmentTable::initialize(uint maxNumberOfFragments,
+		uint numberOfPreallocatedTables) {
+	/*
+	 * Keep the load factor below 0.5 for short probe sequences
+	 */
+	tableCapacityBits_ = 1;
+	while ((1u << tableCapacityBits_) < 2 * maxNumberOfFragments) {
+		tableCapacityBits_++;
+	}
+
+	if (pool_ == nullptr) {
+		pool_ = new BoundedMPMCQueue<NonZSuppressedLkrFragmentTable*>(MaxPoolSize);
+	} else {
+		// Drop tables of the previous configuration
+		NonZSuppressedLkrFragmentTable* table;
+		while (pool_->pop(table)) {
+			delete table;
+		}
+	}
+	for (uint i = 0; i != numberOfPreallocatedTables && i != MaxPoolSize; i++) {
+		pool_->push(new NonZSuppressedLkrFragmentTable());
+	}
+	LOG_INFO("Preallocated " << numberOfPreallocatedTables << " tables for " << maxNumberOfFragments << " non zero suppressed LKr fragments");
+}
+
+NonZSuppressedLkrFragmentTable* NonZSuppressedLkrFragmentTable::acquire() {
+	NonZSuppressedLkrFragmentTable* table;
+	if (pool_ != nullptr && pool_->pop(table)) {
+		return table;
+	}
+	return new NonZSuppressedLkrFragmentTable();
+}
+
+void NonZSuppressedLkrFragmentTable::release(NonZSuppressedLkrFragmentTable* table) {
+	table->clear();
+	if (pool_ == nullptr || table->capacityBits_ != tableCapacityBits_
+			|| !pool_->push(table)) {
+		delete table;
+	}
+}
+
+NonZSuppressedLkrFragmentTable::NonZSuppressedLkrFragmentTable() :
+		capacityBits_(tableCapacityBits_), capacity_(1u << tableCapacityBits_), slots_(
+				new Slot[capacity_]), size_(0) {
+	for (uint_fast32_t i = 0; i != capacity_; i++) {
+		slots_[i].key.store(0, std::memory_order_relaxed);
+		slots_[i].fragment.store(nullptr, std::memory_order_relaxed);
+	}
+}
+
+NonZSuppressedLkrFragmentTable::~NonZSuppressedLkrFragmentTable() {
+	clear();
+	delete[] slots_;
+}
+
+NonZSuppressedLkrFragmentTable::InsertResult NonZSuppressedLkrFragmentTable::insert(
+		const uint_fast16_t crateCREAMID, l1::MEPFragment* fragment, uint_fast16_t& numberOfFragments) {
+	const uint32_t key = crateCREAMID + 1;
+	const uint_fast32_t mask = capacity_ - 1;
+	for (uint_fast32_t i = hash(crateCREAMID), probes = 0; probes != capacity_;
+			i = (i + 1) & mask, probes++) {
+		uint32_t slotKey = slots_[i].key.load(std::memory_order_acquire);
+		if (slotKey == 0) {
+			if (slots_[i].key.compare_exchange_strong(slotKey, key,
+					std::memory_order_acq_rel)) {
+				slots_[i].fragment.store(fragment, std::memory_order_release);
+				numberOfFragments = size_.fetch_add(1, std::memory_order_acq_rel) + 1;
+				return INSERTED;
+			}
+			// Another thread has claimed the slot: slotKey now is its key
+		}
+		if (slotKey == key) {
+			return DUPLICATE;
+		}
+	}
+	LOG_ERROR("Table for non zero suppressed LKr fragments is full");
+	return TABLE_FULL;
+}
+
+l1::MEPFragment* NonZSuppressedLkrFragmentTable::find(const uint_fast16_t crateCREAMID) const {
+	const uint32_t key = crateCREAMID + 1;
+	const uint_fast32_t mask = capacity_ - 1;
+	for (uint_fast32_t i = hash(crateCREAMID), probes = 0; probes != capacity_;
+			i = (i + 1) & mask, probes++) {
+		const uint32_t slotKey = slots_[i].key.load(std::memory_order_acquire);
+		if (slotKey == 0) {
+			return nullptr;
+		}
+		if (slotKey == key) {
+			return slots_[i].fragment.load(std::memory_order_acquire);
+		}
+	}
+	return nullptr;
+}
+
+void NonZSuppressedLkrFragmentTable::clear() {
+	if (size_ == 0) {
+		return;
+	}
+	for (uint_fast32_t i = 0; i != capacity_; i++) {
+		if (slots_[i].key.load(std::memory_order_relaxed) != 0) {
+			delete slots_[i].fragment.load(std::memory_order_relaxed);
+			slots_[i].fragment.store(nullptr, std::memory_order_relaxed);
+			slots_[i].key.store(0, std::memory_order_relaxed);
+		}
+	}
+	size_ = 0;
+}
+
+} /* namespace na62 */
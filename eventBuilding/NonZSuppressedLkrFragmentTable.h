@@ -0,0 +1,190 @@
+/*
+ * NonZSuppressedLkrFragmentTable.h
+ *
+ * Fixed size open addressing hash table storing the non zero suppressed LKr fragments of one event by
+ * their crate/CREAM ID. Insertion is lock-free so that several L1 receiver threads can fill the same
+ * table. Tables are preallocated and recycled via a pool so that no memory is allocated per fragment.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#pragma once
+#ifndef NONZSUPPRESSEDLKRFRAGMENTTABLE_H_
+#define NONZSUPPRESSEDLKRFRAGMENTTABLE_H_
+
+#include <sys/types.h>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <boost/noncopyable.hpp>
+
+#include "../utils/BoundedMPMCQueue.h"
+
+namespace na62 {
+namespace l1 {
+class MEPFragment;
+} /* namespace l1 */
+
+class NonZSuppressedLkrFragmentTable: private boost::noncopyable {
+private:
+	struct Slot {
+		/*
+		 * crateCREAMID + 1 or 0 if the slot is empty
+		 */
+		std::atomic<uint32_t> key;
+		std::atomic<l1::MEPFragment*> fragment;
+	};
+
+public:
+	typedef std::pair<uint_fast16_t, l1::MEPFragment*> value_type;
+
+	enum InsertResult {
+		INSERTED, DUPLICATE, TABLE_FULL
+	};
+
+	/*
+	 * Forward iterator over all stored (crateCREAMID, fragment) pairs
+	 */
+	class Iterator: public std::iterator<std::forward_iterator_tag, value_type> {
+	public:
+		Iterator(const Slot* slot, const Slot* end) :
+				slot_(slot), end_(end) {
+			skipEmptySlots();
+		}
+
+		const value_type& operator*() const {
+			return current_;
+		}
+
+		const value_type* operator->() const {
+			return &current_;
+		}
+
+		Iterator& operator++() {
+			++slot_;
+			skipEmptySlots();
+			return *this;
+		}
+
+		bool operator==(const Iterator& other) const {
+			return slot_ == other.slot_;
+		}
+
+		bool operator!=(const Iterator& other) const {
+			return slot_ != other.slot_;
+		}
+
+	private:
+		void skipEmptySlots() {
+			for (; slot_ != end_; ++slot_) {
+				l1::MEPFragment* fragment = slot_->fragment.load(std::memory_order_acquire);
+				if (fragment != nullptr) {
+					current_ = value_type(slot_->key.load(std::memory_order_relaxed) - 1, fragment);
+					return;
+				}
+			}
+		}
+
+		const Slot* slot_;
+		const Slot* end_;
+		value_type current_;
+	};
+
+	/*
+	 * Zero-copy view of a table. An empty view is returned for events without non zero suppressed data
+	 */
+	class View {
+	public:
+		View(const NonZSuppressedLkrFragmentTable* table) :
+				table_(table) {
+		}
+
+		Iterator begin() const {
+			if (table_ == nullptr) {
+				return Iterator(nullptr, nullptr);
+			}
+			return Iterator(table_->slots_, table_->slots_ + table_->capacity_);
+		}
+
+		Iterator end() const {
+			if (table_ == nullptr) {
+				return Iterator(nullptr, nullptr);
+			}
+			return Iterator(table_->slots_ + table_->capacity_, table_->slots_ + table_->capacity_);
+		}
+
+		uint_fast16_t size() const {
+			return table_ == nullptr ? 0 : table_->size();
+		}
+
+		bool empty() const {
+			return size() == 0;
+		}
+
+	private:
+		const NonZSuppressedLkrFragmentTable* table_;
+	};
+
+	/**
+	 * Every table can store up to <maxNumberOfFragments> fragments. <numberOfPreallocatedTables> tables are
+	 * allocated immediately, more are allocated on demand and kept in the pool afterwards.
+	 */
+	static void initialize(uint maxNumberOfFragments, uint numberOfPreallocatedTables);
+
+	/**
+	 * Returns an empty table from the pool
+	 */
+	static NonZSuppressedLkrFragmentTable* acquire();
+
+	/**
+	 * Deletes all fragments stored in <table> and puts it back into the pool
+	 */
+	static void release(NonZSuppressedLkrFragmentTable* table);
+
+	/**
+	 * Stores the fragment unless a fragment with the same crate/CREAM ID has already been stored or the table
+	 * is full. If INSERTED is returned <numberOfFragments> is set to the number of fragments stored including
+	 * this one.
+	 */
+	InsertResult insert(const uint_fast16_t crateCREAMID, l1::MEPFragment* fragment,
+			uint_fast16_t& numberOfFragments);
+
+	/**
+	 * Returns the fragment stored for <crateCREAMID> or nullptr
+	 */
+	l1::MEPFragment* find(const uint_fast16_t crateCREAMID) const;
+
+	inline uint_fast16_t size() const {
+		return size_.load(std::memory_order_acquire);
+	}
+
+private:
+	NonZSuppressedLkrFragmentTable();
+	~NonZSuppressedLkrFragmentTable();
+
+	/*
+	 * Deletes all stored fragments and empties the table. Must not be called concurrently to insert()
+	 */
+	void clear();
+
+	inline uint_fast32_t hash(const uint_fast16_t crateCREAMID) const {
+		// Fibonacci hashing
+		return ((uint32_t) crateCREAMID * 2654435769u) >> (32 - capacityBits_);
+	}
+
+	/*
+	 * Tables allocated before a reinitialization keep their capacity
+	 */
+	const uint_fast32_t capacityBits_;
+	const uint_fast32_t capacity_;
+	Slot* slots_;
+	std::atomic<uint_fast16_t> size_;
+
+	static uint_fast32_t tableCapacityBits_;
+	static BoundedMPMCQueue<NonZSuppressedLkrFragmentTable*>* pool_;
+};
+
+} /* namespace na62 */
+
+#endif /* NONZSUPPRESSEDLKRFRAGMENTTABLE_H_ */
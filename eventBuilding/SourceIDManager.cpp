@@ -20,109 +20,154 @@
 
 namespace na62 {
 uint_fast8_t SourceIDManager::NUMBER_OF_L0_DATA_SOURCES = 0; // Must be greater than 1!!!
-uint_fast8_t * SourceIDManager::L0_DATA_SOURCE_IDS = 0; // All sourceIDs participating in L1 (not the CREAM 0x24)
-uint_fast8_t * SourceIDManager::L0_DATA_SOURCE_ID_TO_NUM = 0;
+const uint_fast8_t * SourceIDManager::L0_DATA_SOURCE_IDS = 0; // All sourceIDs participating in L1 (not the CREAM 0x24)
 uint_fast8_t SourceIDManager::LARGEST_L0_DATA_SOURCE_ID = 0;
 
-uint_fast16_t * SourceIDManager::L0_DATA_SOURCE_ID_TO_PACKNUM = 0; // Expected packets per sourceID
-uint_fast16_t * SourceIDManager::L0_DATA_SOURCE_NUM_TO_PACKNUM = 0;
-uint_fast16_t SourceIDManager::NUMBER_OF_EXPECTED_L0_PACKETS_PER_EVENT = 0; // The sum of all DATA_SOURCE_ID_TO_PACKNUM entries
+const SourceIDManager::SourceDescriptor * SourceIDManager::L0_SOURCE_DESCRIPTORS = nullptr;
+const uint16_t * SourceIDManager::L0_DATA_SOURCE_NUM_TO_PACKNUM = nullptr;
+uint_fast16_t SourceIDManager::NUMBER_OF_EXPECTED_L0_PACKETS_PER_EVENT = 0; // The sum of all DATA_SOURCE_NUM_TO_PACKNUM entries
 
 uint_fast8_t SourceIDManager::NUMBER_OF_L1_DATA_SOURCES = 0; // Must be greater than 1!!!
-uint_fast8_t * SourceIDManager::L1_DATA_SOURCE_IDS = 0; // All sourceIDs participating in L1 (not the CREAM 0x24)
-uint_fast8_t * SourceIDManager::L1_DATA_SOURCE_ID_TO_NUM = 0;
+const uint_fast8_t * SourceIDManager::L1_DATA_SOURCE_IDS = 0; // All sourceIDs participating in L1 (not the CREAM 0x24)
 uint_fast8_t SourceIDManager::LARGEST_L1_DATA_SOURCE_ID = 0;
 
-uint_fast16_t * SourceIDManager::L1_DATA_SOURCE_ID_TO_PACKNUM = 0; // Expected packets per sourceID
-uint_fast16_t * SourceIDManager::L1_DATA_SOURCE_NUM_TO_PACKNUM = 0;
-uint_fast16_t SourceIDManager::NUMBER_OF_EXPECTED_L1_PACKETS_PER_EVENT = 0; // The sum of all DATA_SOURCE_ID_TO_PACKNUM entries
+const SourceIDManager::SourceDescriptor * SourceIDManager::L1_SOURCE_DESCRIPTORS = nullptr;
+const uint16_t * SourceIDManager::L1_DATA_SOURCE_NUM_TO_PACKNUM = nullptr;
+uint_fast16_t SourceIDManager::NUMBER_OF_EXPECTED_L1_PACKETS_PER_EVENT = 0; // The sum of all DATA_SOURCE_NUM_TO_PACKNUM entries
+
+const SourceIDManager::SubSourceIDLayout * SourceIDManager::L0_SUB_SOURCE_ID_LAYOUTS = nullptr;
+const SourceIDManager::SubSourceIDLayout * SourceIDManager::L1_SUB_SOURCE_ID_LAYOUTS = nullptr;
 
 uint_fast8_t SourceIDManager::TS_SOURCEID_NUM;
+
 bool SourceIDManager::L0TP_ACTIVE = false;
 
+std::atomic<SourceLayout*> SourceIDManager::currentLayout_(nullptr);
+SourceLayout* SourceIDManager::retiredLayout_ = nullptr;
+SourceLayout* SourceIDManager::pendingLayout_ = nullptr;
+uint32_t SourceIDManager::nextLayoutVersion_ = 0;
+std::mutex SourceIDManager::layoutMutex_;
+
 void SourceIDManager::Initialize(const uint_fast16_t timeStampSourceID,
 		std::vector<std::pair<int, int> > l0sourceIDs,
 		std::vector<std::pair<int, int> > l1sourceIDs) {
-
 	/*
-	 * OPTION_DATA_SOURCE_IDS
-	 *
+	 * Initialize may be called again with a new layout (see EventPool::reconfigure). This publishes the
+	 * layout immediately and drops any scheduled one
 	 */
-	NUMBER_OF_L0_DATA_SOURCES = l0sourceIDs.size();
-	L0_DATA_SOURCE_IDS = new uint_fast8_t[NUMBER_OF_L0_DATA_SOURCES];
-	L0_DATA_SOURCE_NUM_TO_PACKNUM = new uint_fast16_t[NUMBER_OF_L0_DATA_SOURCES];
-
-	NUMBER_OF_L1_DATA_SOURCES = l1sourceIDs.size();
-	L1_DATA_SOURCE_IDS = new uint_fast8_t[NUMBER_OF_L1_DATA_SOURCES];
-	L1_DATA_SOURCE_NUM_TO_PACKNUM = new uint_fast16_t[NUMBER_OF_L1_DATA_SOURCES];
-
-	int pos = -1;
-	for (auto& pair : l0sourceIDs) {
-		L0_DATA_SOURCE_IDS[++pos] = pair.first;
-		L0_DATA_SOURCE_NUM_TO_PACKNUM[pos] = pair.second;
-		NUMBER_OF_EXPECTED_L0_PACKETS_PER_EVENT += pair.second;
-	}
-	pos = -1;
-	for (auto& pair : l1sourceIDs) {
-		L1_DATA_SOURCE_IDS[++pos] = pair.first;
-		L1_DATA_SOURCE_NUM_TO_PACKNUM[pos] = pair.second;
-		NUMBER_OF_EXPECTED_L1_PACKETS_PER_EVENT += pair.second;
-	}
-
-	LARGEST_L0_DATA_SOURCE_ID = 0;
-	for (int i = 0; i < NUMBER_OF_L0_DATA_SOURCES; i++) {
-		if (LARGEST_L0_DATA_SOURCE_ID < L0_DATA_SOURCE_IDS[i]) {
-			LARGEST_L0_DATA_SOURCE_ID = L0_DATA_SOURCE_IDS[i];
-		}
+	std::lock_guard<std::mutex> lock(layoutMutex_);
+	if (pendingLayout_ != nullptr) {
+		pendingLayout_->release();
+		pendingLayout_ = nullptr;
 	}
+	publishLayout(new SourceLayout(nextLayoutVersion_++, timeStampSourceID, l0sourceIDs, l1sourceIDs));
+}
 
-	LARGEST_L1_DATA_SOURCE_ID = 0;
-	for (int i = 0; i < NUMBER_OF_L1_DATA_SOURCES; i++) {
-		if (LARGEST_L1_DATA_SOURCE_ID < L1_DATA_SOURCE_IDS[i]) {
-			LARGEST_L1_DATA_SOURCE_ID = L1_DATA_SOURCE_IDS[i];
-		}
+void SourceIDManager::scheduleLayout(const uint_fast16_t timeStampSourceID,
+		const std::vector<std::pair<int, int> >& l0SourceIDs,
+		const std::vector<std::pair<int, int> >& l1SourceIDs) {
+	std::lock_guard<std::mutex> lock(layoutMutex_);
+	SourceLayout* layout = new SourceLayout(nextLayoutVersion_++, timeStampSourceID, l0SourceIDs,
+			l1SourceIDs);
+	if (pendingLayout_ != nullptr) {
+		pendingLayout_->release();
 	}
+	pendingLayout_ = layout;
+	LOG_INFO("Scheduled source layout version " << layout->version << " with " << (int) layout->numberOfL0Sources << " L0 and " << (int) layout->numberOfL1Sources << " L1 sources for the next burst");
+}
 
-	L0_DATA_SOURCE_ID_TO_NUM = new uint_fast8_t[LARGEST_L0_DATA_SOURCE_ID + 1];
-	L0_DATA_SOURCE_ID_TO_PACKNUM = new uint_fast16_t[LARGEST_L0_DATA_SOURCE_ID + 1];
-
-	L1_DATA_SOURCE_ID_TO_NUM = new uint_fast8_t[LARGEST_L1_DATA_SOURCE_ID + 1];
-	L1_DATA_SOURCE_ID_TO_PACKNUM = new uint_fast16_t[LARGEST_L1_DATA_SOURCE_ID + 1];
-
-	memset(L0_DATA_SOURCE_ID_TO_NUM, 0xFF, LARGEST_L0_DATA_SOURCE_ID + 1);
-	memset(L1_DATA_SOURCE_ID_TO_NUM, 0xFF, LARGEST_L1_DATA_SOURCE_ID + 1);
+bool SourceIDManager::hasPendingLayout() {
+	std::lock_guard<std::mutex> lock(layoutMutex_);
+	return pendingLayout_ != nullptr;
+}
 
-	for (uint_fast8_t i = 0; i < NUMBER_OF_L0_DATA_SOURCES; i++) {
-		L0_DATA_SOURCE_ID_TO_NUM[L0_DATA_SOURCE_IDS[i]] = i;
-		L0_DATA_SOURCE_ID_TO_PACKNUM[L0_DATA_SOURCE_IDS[i]] =
-				L0_DATA_SOURCE_NUM_TO_PACKNUM[i];
+bool SourceIDManager::switchToPendingLayout(const bool onlySameShape) {
+	std::lock_guard<std::mutex> lock(layoutMutex_);
+	if (pendingLayout_ == nullptr) {
+		return false;
+	}
+	if (onlySameShape && !pendingLayout_->hasSameShape(*currentLayout_.load(std::memory_order_relaxed))) {
+		return false;
 	}
-	for (uint_fast8_t i = 0; i < NUMBER_OF_L1_DATA_SOURCES; i++) {
-		L1_DATA_SOURCE_ID_TO_NUM[L1_DATA_SOURCE_IDS[i]] = i;
-		L1_DATA_SOURCE_ID_TO_PACKNUM[L1_DATA_SOURCE_IDS[i]] =
-				L1_DATA_SOURCE_NUM_TO_PACKNUM[i];
+	publishLayout(pendingLayout_);
+	pendingLayout_ = nullptr;
+	LOG_INFO("Switched to source layout version " << getLayout()->version);
+	return true;
+}
+
+void SourceIDManager::publishLayout(SourceLayout* layout) {
+	/*
+	 * The layout retired at the last switch has had a whole burst for all readers of the fields below to
+	 * move on. Events still using it hold their own reference
+	 */
+	if (retiredLayout_ != nullptr) {
+		retiredLayout_->release();
 	}
+	retiredLayout_ = currentLayout_.load(std::memory_order_relaxed);
+	currentLayout_.store(layout, std::memory_order_seq_cst);
+
+	NUMBER_OF_L0_DATA_SOURCES = layout->numberOfL0Sources;
+	NUMBER_OF_L1_DATA_SOURCES = layout->numberOfL1Sources;
+	L0_DATA_SOURCE_IDS = layout->l0SourceIDs;
+	L1_DATA_SOURCE_IDS = layout->l1SourceIDs;
+	LARGEST_L0_DATA_SOURCE_ID = layout->largestL0SourceID;
+	LARGEST_L1_DATA_SOURCE_ID = layout->largestL1SourceID;
+
+	L0_SOURCE_DESCRIPTORS = layout->l0Descriptors;
+	L0_DATA_SOURCE_NUM_TO_PACKNUM = layout->l0PacketsBySourceNum;
+	NUMBER_OF_EXPECTED_L0_PACKETS_PER_EVENT = layout->expectedL0PacketsPerEvent;
+	L1_SOURCE_DESCRIPTORS = layout->l1Descriptors;
+	L1_DATA_SOURCE_NUM_TO_PACKNUM = layout->l1PacketsBySourceNum;
+	NUMBER_OF_EXPECTED_L1_PACKETS_PER_EVENT = layout->expectedL1PacketsPerEvent;
+
+	L0_SUB_SOURCE_ID_LAYOUTS = layout->l0SubSourceIDLayouts.data();
+	L1_SUB_SOURCE_ID_LAYOUTS = layout->l1SubSourceIDLayouts.data();
+
+	L0TP_ACTIVE = layout->l0tpActive;
+	TS_SOURCEID_NUM = layout->timeStampSourceNum;
+}
 
-	L0TP_ACTIVE = SourceIDManager::isL0TPActive();
-	TS_SOURCEID_NUM = sourceIDToNum(timeStampSourceID);
-	if (!SourceIDManager::checkL0SourceID(timeStampSourceID)) {
-		LOG_ERROR("The timestamp reference source ID is not part of the L0SourceIDs list");
-		exit(1);
+SourceLayout* SourceIDManager::getPendingLayoutToModify() {
+	if (pendingLayout_ == nullptr) {
+		const SourceLayout* currentLayout = getLayout();
+		if (currentLayout == nullptr) {
+			LOG_ERROR("SourceIDManager::Initialize must be called before the sourceSubIDs can be set");
+			exit(1);
+		}
+		pendingLayout_ = new SourceLayout(nextLayoutVersion_++, *currentLayout);
+		LOG_INFO("Scheduled source layout version " << pendingLayout_->version << " with new sourceSubIDs for the next burst");
 	}
+	return pendingLayout_;
 }
 
-bool SourceIDManager::checkL0SourceID(const uint_fast8_t sourceID) {
-	if (sourceID > LARGEST_L0_DATA_SOURCE_ID) {
-		return false;
+void SourceIDManager::setExpectedSubSourceIDs(const uint_fast8_t sourceID,
+		const std::vector<uint_fast16_t>& subSourceIDs) {
+	std::lock_guard<std::mutex> lock(layoutMutex_);
+	SourceLayout* layout = getPendingLayoutToModify();
+	if (!layout->l0Descriptors[sourceID].valid) {
+		LOG_ERROR("Unable to set the sourceSubIDs of the unknown sourceID 0x" << std::hex << (int) sourceID);
+		exit(1);
+	}
+	if (subSourceIDs.size() != layout->l0Descriptors[sourceID].expectedPackets) {
+		LOG_ERROR("Expecting " << layout->l0Descriptors[sourceID].expectedPackets << " packets from sourceID 0x" << std::hex << (int) sourceID << std::dec << " but " << subSourceIDs.size() << " sourceSubIDs are given");
+		exit(1);
 	}
-	return L0_DATA_SOURCE_ID_TO_NUM[sourceID] != (uint_fast8_t) 0xFF;
+	layout->setSubSourceIDs(false, layout->l0Descriptors[sourceID].sourceNum, subSourceIDs);
 }
 
-bool SourceIDManager::checkL1SourceID(const uint_fast8_t sourceID) {
-	if (sourceID > LARGEST_L1_DATA_SOURCE_ID) {
-		return false;
+void SourceIDManager::setExpectedL1SubSourceIDs(const uint_fast8_t sourceID,
+		const std::vector<uint_fast16_t>& subSourceIDs) {
+	std::lock_guard<std::mutex> lock(layoutMutex_);
+	SourceLayout* layout = getPendingLayoutToModify();
+	if (!layout->l1Descriptors[sourceID].valid) {
+		LOG_ERROR("Unable to set the sourceSubIDs of the unknown L1 sourceID 0x" << std::hex << (int) sourceID);
+		exit(1);
+	}
+	if (subSourceIDs.size() != layout->l1Descriptors[sourceID].expectedPackets) {
+		LOG_ERROR("Expecting " << layout->l1Descriptors[sourceID].expectedPackets << " L1 packets from sourceID 0x" << std::hex << (int) sourceID << std::dec << " but " << subSourceIDs.size() << " sourceSubIDs are given");
+		exit(1);
 	}
-	return L1_DATA_SOURCE_ID_TO_NUM[sourceID] != (uint_fast8_t) 0xFF;
+	layout->setSubSourceIDs(true, layout->l1Descriptors[sourceID].sourceNum, subSourceIDs);
 }
 
 std::string SourceIDManager::sourceIdToDetectorName(uint_fast8_t sourceID) {
@@ -9,8 +9,10 @@
 #define SOURCEIDMANAGER_H_
 
 #include <vector>
+#include <atomic>
 #include <cstdint>
 #include <map>
+#include <mutex>
 #include <utility>
 #include <sys/types.h>
 
@@ -32,6 +34,11 @@
 #define SOURCE_ID_L2 0x48
 #define SOURCE_ID_NSTD 0x4C
 
+#ifdef NA62_STATIC_SOURCE_LAYOUT
+#include "StaticSourceLayout.h"
+#endif
+#include "SourceLayout.h"
+
 namespace na62 {
 
 class SourceIDManager {
@@ -39,23 +46,33 @@ class SourceIDManager {
 public:
 	/**
 	 * Data Source IDs
+	 *
+	 * All following fields point into or are copied from the current SourceLayout (see getLayout). They
+	 * are only updated by Initialize and switchToPendingLayout.
 	 */
 	static uint_fast8_t NUMBER_OF_L0_DATA_SOURCES; // Must be greater than 1!!!
 	static uint_fast8_t NUMBER_OF_L1_DATA_SOURCES; // Must be greater than 0!!!
-	static uint_fast8_t * L0_DATA_SOURCE_IDS; // All sourceIDs participating in L1 (not the CREAM 0x24)
-	static uint_fast8_t * L0_DATA_SOURCE_ID_TO_NUM;
-	static uint_fast8_t * L1_DATA_SOURCE_IDS; // All sourceIDs participating in L1 (not the CREAM 0x24)
-	static uint_fast8_t * L1_DATA_SOURCE_ID_TO_NUM;
+	static const uint_fast8_t * L0_DATA_SOURCE_IDS; // All sourceIDs participating in L1 (not the CREAM 0x24)
+	static const uint_fast8_t * L1_DATA_SOURCE_IDS; // All sourceIDs participating in L1 (not the CREAM 0x24)
 	static uint_fast8_t LARGEST_L0_DATA_SOURCE_ID; // ?what for?
 	static uint_fast8_t LARGEST_L1_DATA_SOURCE_ID; // ?what for?
 
-	static uint_fast16_t * L0_DATA_SOURCE_ID_TO_PACKNUM; // Expected packets per sourceID
-	static uint_fast16_t * L0_DATA_SOURCE_NUM_TO_PACKNUM;
-	static uint_fast16_t NUMBER_OF_EXPECTED_L0_PACKETS_PER_EVENT; // The sum of all DATA_SOURCE_ID_TO_PACKNUM entries
+	typedef SourceLayout::SourceDescriptor SourceDescriptor;
+
+	static const SourceDescriptor * L0_SOURCE_DESCRIPTORS; // By sourceID
+	static const uint16_t * L0_DATA_SOURCE_NUM_TO_PACKNUM;
+	static uint_fast16_t NUMBER_OF_EXPECTED_L0_PACKETS_PER_EVENT; // The sum of all DATA_SOURCE_NUM_TO_PACKNUM entries
+
+	static const SourceDescriptor * L1_SOURCE_DESCRIPTORS; // By sourceID
+	static const uint16_t * L1_DATA_SOURCE_NUM_TO_PACKNUM;
+	static uint_fast16_t NUMBER_OF_EXPECTED_L1_PACKETS_PER_EVENT; // The sum of all DATA_SOURCE_NUM_TO_PACKNUM entries
+
+	typedef SourceLayout::SubSourceIDLayout SubSourceIDLayout;
 
-	static uint_fast16_t * L1_DATA_SOURCE_ID_TO_PACKNUM; // Expected packets per sourceID
-	static uint_fast16_t * L1_DATA_SOURCE_NUM_TO_PACKNUM;
-	static uint_fast16_t NUMBER_OF_EXPECTED_L1_PACKETS_PER_EVENT; // The sum of all DATA_SOURCE_ID_TO_PACKNUM entries
+	static const uint_fast16_t INVALID_SUB_SOURCE_ID_BIT = SourceLayout::INVALID_SUB_SOURCE_ID_BIT;
+
+	static const SubSourceIDLayout * L0_SUB_SOURCE_ID_LAYOUTS; // By sourceNum
+	static const SubSourceIDLayout * L1_SUB_SOURCE_ID_LAYOUTS; // By L1 sourceNum
 
 	static uint_fast8_t TS_SOURCEID_NUM;
 
@@ -70,13 +87,44 @@ public:
 			std::vector<std::pair<int, int> > l0SourceIDs,
 			std::vector<std::pair<int, int> > l1SourceIDs);
 
+	/**
+	 * Builds a new SourceLayout that will be published by the next call of switchToPendingLayout, which
+	 * the BurstIdHandler does at the end of every burst (see EventPool::switchSourceLayout). Replaces any
+	 * layout scheduled before. May be called by any thread at any time.
+	 */
+	static void scheduleLayout(const uint_fast16_t timeStampSourceID,
+			const std::vector<std::pair<int, int> >& l0SourceIDs,
+			const std::vector<std::pair<int, int> >& l1SourceIDs);
+
+	static bool hasPendingLayout();
+
+	/**
+	 * Publishes the layout scheduled by scheduleLayout. Threads still reading the fields above may
+	 * continue to use the previous layout until the following call of this method (one burst of grace
+	 * period), Events keep their own reference to the layout they have been built with.
+	 *
+	 * With <onlySameShape> the scheduled layout is only published if it has the same shape as the current
+	 * one (see SourceLayout::hasSameShape) and stays scheduled otherwise.
+	 *
+	 * Returns false if no layout has been published
+	 */
+	static bool switchToPendingLayout(const bool onlySameShape = false);
+
+	/**
+	 * The currently published layout. Use SourceLayout::acquire to keep it beyond the next switch. May be
+	 * called by any thread at any time
+	 */
+	static inline const SourceLayout* getLayout() {
+		return currentLayout_.load(std::memory_order_seq_cst);
+	}
+
 	static inline uint_fast16_t getExpectedPacksBySourceNum(
 			const uint_fast8_t sourceNum) {
 		return L0_DATA_SOURCE_NUM_TO_PACKNUM[sourceNum];
 	}
 
 	static inline uint_fast16_t getExpectedPacksBySourceID(const uint_fast8_t sourceID) {
-		return L0_DATA_SOURCE_ID_TO_PACKNUM[sourceID];
+		return L0_SOURCE_DESCRIPTORS[sourceID].expectedPackets;
 	}
 
 	static inline uint_fast16_t getExpectedL1PacksBySourceNum(
@@ -85,7 +133,47 @@ public:
 	}
 
 	static inline uint_fast16_t getExpectedL1PacksBySourceID(const uint_fast8_t sourceID) {
-		return L1_DATA_SOURCE_ID_TO_PACKNUM[sourceID];
+		return L1_SOURCE_DESCRIPTORS[sourceID].expectedPackets;
+	}
+
+	/**
+	 * Defines which sourceSubIDs are sent by the given source. The number of sourceSubIDs must be equal to the
+	 * number of expected packets of that source. Without this call any sourceSubID is accepted until the expected
+	 * number of packets has been received, which is needed for sources with non consecutive sourceSubIDs like the
+	 * LKr CREAMs
+	 *
+	 * A published layout is never modified as Subevents read it concurrently: the sourceSubIDs are set in the
+	 * layout scheduled by scheduleLayout, or in a copy of the current layout scheduled by this call, and take
+	 * effect with the next switchToPendingLayout
+	 */
+	static void setExpectedSubSourceIDs(const uint_fast8_t sourceID,
+			const std::vector<uint_fast16_t>& subSourceIDs);
+
+	static void setExpectedL1SubSourceIDs(const uint_fast8_t sourceID,
+			const std::vector<uint_fast16_t>& subSourceIDs);
+
+	/*
+	 * Returns the bit number of the sourceSubID within the Subevents of the given source or
+	 * INVALID_SUB_SOURCE_ID_BIT if the sourceSubID is not expected or the sourceSubIDs of the source are not configured
+	 */
+	static inline uint_fast16_t getSubSourceIDBit(const uint_fast8_t sourceNum,
+			const uint_fast16_t subSourceID) {
+		return L0_SUB_SOURCE_ID_LAYOUTS[sourceNum].getBit(subSourceID);
+	}
+
+	static inline uint_fast16_t getL1SubSourceIDBit(const uint_fast8_t sourceNum,
+			const uint_fast16_t subSourceID) {
+		return L1_SUB_SOURCE_ID_LAYOUTS[sourceNum].getBit(subSourceID);
+	}
+
+	static inline uint_fast16_t getSubSourceIDOfBit(const uint_fast8_t sourceNum,
+			const uint_fast16_t bit) {
+		return L0_SUB_SOURCE_ID_LAYOUTS[sourceNum].bitToSubID[bit];
+	}
+
+	static inline uint_fast16_t getL1SubSourceIDOfBit(const uint_fast8_t sourceNum,
+			const uint_fast16_t bit) {
+		return L1_SUB_SOURCE_ID_LAYOUTS[sourceNum].bitToSubID[bit];
 	}
 
 
@@ -213,40 +301,176 @@ public:
 	 * 0 <= sourceID < L1_LARGEST_DATA_SOURCE_ID
 	 */
 	static inline uint_fast8_t sourceIDToNum(const uint_fast8_t sourceID) {
-		return L0_DATA_SOURCE_ID_TO_NUM[sourceID];
+#ifdef NA62_STATIC_SOURCE_LAYOUT
+		if (__builtin_constant_p(sourceID)) {
+			return StaticSourceLayout::l0SourceIDToNum(sourceID);
+		}
+#endif
+		return L0_SOURCE_DESCRIPTORS[sourceID].sourceNum;
+	}
+
+	/*
+	 * Same as sourceIDToNum for the given layout instead of the current one
+	 */
+	static inline uint_fast8_t sourceIDToNum(const SourceLayout& layout, const uint_fast8_t sourceID) {
+#ifdef NA62_STATIC_SOURCE_LAYOUT
+		if (__builtin_constant_p(sourceID)) {
+			return StaticSourceLayout::l0SourceIDToNum(sourceID);
+		}
+#endif
+		return layout.l0Descriptors[sourceID].sourceNum;
 	}
 
 	/*
 	 * 0 <= sourceNum < L1_NUMBER_OF_DATA_SOURCES
 	 */
 	static inline uint_fast8_t sourceNumToID(const uint_fast8_t sourceNum) {
+#ifdef NA62_STATIC_SOURCE_LAYOUT
+		return StaticSourceLayout::L0SourceIDs[sourceNum];
+#else
 		return L0_DATA_SOURCE_IDS[sourceNum];
+#endif
+	}
+
+	static inline uint_fast8_t sourceNumToID(const SourceLayout& layout, const uint_fast8_t sourceNum) {
+#ifdef NA62_STATIC_SOURCE_LAYOUT
+		(void) layout;
+		return StaticSourceLayout::L0SourceIDs[sourceNum];
+#else
+		return layout.l0SourceIDs[sourceNum];
+#endif
 	}
 
 	/*
 	 * sourceID must be a valid L1 SourceID! So use checkSourceID if you are not sure!
 	 */
 	static inline uint_fast8_t l1SourceIDToNum(const uint_fast8_t sourceID) {
-		return L1_DATA_SOURCE_ID_TO_NUM[sourceID];
+#ifdef NA62_STATIC_SOURCE_LAYOUT
+		if (__builtin_constant_p(sourceID)) {
+			return StaticSourceLayout::l1SourceIDToNum(sourceID);
+		}
+#endif
+		return L1_SOURCE_DESCRIPTORS[sourceID].sourceNum;
+	}
+
+	static inline uint_fast8_t l1SourceIDToNum(const SourceLayout& layout, const uint_fast8_t sourceID) {
+#ifdef NA62_STATIC_SOURCE_LAYOUT
+		if (__builtin_constant_p(sourceID)) {
+			return StaticSourceLayout::l1SourceIDToNum(sourceID);
+		}
+#endif
+		return layout.l1Descriptors[sourceID].sourceNum;
 	}
 
 	/*
 	 * 0 <= sourceNum < L1_NUMBER_OF_DATA_SOURCES
 	 */
 	static inline uint_fast8_t l1SourceNumToID(const uint_fast8_t sourceNum) {
+#ifdef NA62_STATIC_SOURCE_LAYOUT
+		return StaticSourceLayout::L1SourceIDs[sourceNum];
+#else
 		return L1_DATA_SOURCE_IDS[sourceNum];
+#endif
+	}
+
+	static inline uint_fast8_t l1SourceNumToID(const SourceLayout& layout, const uint_fast8_t sourceNum) {
+#ifdef NA62_STATIC_SOURCE_LAYOUT
+		(void) layout;
+		return StaticSourceLayout::L1SourceIDs[sourceNum];
+#else
+		return layout.l1SourceIDs[sourceNum];
+#endif
+	}
+
+	/**
+	 * Calls function(sourceNum) for every L0 sourceNum in ascending order. With NA62_STATIC_SOURCE_LAYOUT the
+	 * iteration is unrolled at compile time
+	 */
+	template<typename Function>
+	static inline void forEachL0SourceNum(Function function) {
+#ifdef NA62_STATIC_SOURCE_LAYOUT
+		StaticSourceLayout::ForEachSourceNum<0, StaticSourceLayout::NumberOfL0Sources>::run(function);
+#else
+		for (uint_fast8_t sourceNum = 0; sourceNum != NUMBER_OF_L0_DATA_SOURCES; sourceNum++) {
+			function(sourceNum);
+		}
+#endif
+	}
+
+	/**
+	 * Same as forEachL0SourceNum for the sources of the given layout
+	 */
+	template<typename Function>
+	static inline void forEachL0SourceNum(const SourceLayout& layout, Function function) {
+#ifdef NA62_STATIC_SOURCE_LAYOUT
+		(void) layout;
+		StaticSourceLayout::ForEachSourceNum<0, StaticSourceLayout::NumberOfL0Sources>::run(function);
+#else
+		for (uint_fast8_t sourceNum = 0; sourceNum != layout.numberOfL0Sources; sourceNum++) {
+			function(sourceNum);
+		}
+#endif
+	}
+
+	/**
+	 * Same as forEachL0SourceNum for the L1 sources
+	 */
+	template<typename Function>
+	static inline void forEachL1SourceNum(Function function) {
+#ifdef NA62_STATIC_SOURCE_LAYOUT
+		StaticSourceLayout::ForEachSourceNum<0, StaticSourceLayout::NumberOfL1Sources>::run(function);
+#else
+		for (uint_fast8_t sourceNum = 0; sourceNum != NUMBER_OF_L1_DATA_SOURCES; sourceNum++) {
+			function(sourceNum);
+		}
+#endif
+	}
+
+	template<typename Function>
+	static inline void forEachL1SourceNum(const SourceLayout& layout, Function function) {
+#ifdef NA62_STATIC_SOURCE_LAYOUT
+		(void) layout;
+		StaticSourceLayout::ForEachSourceNum<0, StaticSourceLayout::NumberOfL1Sources>::run(function);
+#else
+		for (uint_fast8_t sourceNum = 0; sourceNum != layout.numberOfL1Sources; sourceNum++) {
+			function(sourceNum);
+		}
+#endif
 	}
 
 	/*
 	 * @return bool <true> if the sourceID is correct, <false> else
 	 */
-	static bool checkL0SourceID(const uint_fast8_t sourceID);
+	static inline bool checkL0SourceID(const uint_fast8_t sourceID) {
+		return L0_SOURCE_DESCRIPTORS[sourceID].valid;
+	}
 	/*
 	 * @return bool <true> if the sourceID is correct, <false> else
 	 */
-	static bool checkL1SourceID(const uint_fast8_t sourceID);
+	static inline bool checkL1SourceID(const uint_fast8_t sourceID) {
+		return L1_SOURCE_DESCRIPTORS[sourceID].valid;
+	}
 
 	static std::string sourceIdToDetectorName(uint_fast8_t sourceID);
+
+private:
+	/*
+	 * Makes <layout> the current one and updates all public fields. The previous layout stays alive until
+	 * the next call
+	 */
+	static void publishLayout(SourceLayout* layout);
+
+	/*
+	 * Returns the scheduled layout, scheduling a copy of the current one if there is none. Must be called
+	 * with layoutMutex_ locked
+	 */
+	static SourceLayout* getPendingLayoutToModify();
+
+	static std::atomic<SourceLayout*> currentLayout_;
+	static SourceLayout* retiredLayout_;
+	static SourceLayout* pendingLayout_;
+	static uint32_t nextLayoutVersion_;
+	static std::mutex layoutMutex_;
 };
 
 } /* namespace na62 */
@@ -0,0 +1,139 @@
+/*
+ * SourceLayout.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "SourceLayout.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#include "../options/Logging.h"
+#include "SourceIDManager.h"
+
+namespace na62 {
+
+static SourceLayout::SubSourceIDLayout createSubSourceIDLayout(
+		const std::vector<uint_fast16_t>& subSourceIDs) {
+	SourceLayout::SubSourceIDLayout layout;
+	layout.configured = true;
+	uint_fast16_t largestSubSourceID = 0;
+	for (uint_fast16_t subSourceID : subSourceIDs) {
+		largestSubSourceID = std::max(largestSubSourceID, subSourceID);
+	}
+	layout.subIDToBit.assign(subSourceIDs.empty() ? 0 : largestSubSourceID + 1,
+			(uint16_t) SourceLayout::INVALID_SUB_SOURCE_ID_BIT);
+	for (uint16_t bit = 0; bit != subSourceIDs.size(); bit++) {
+		if (layout.subIDToBit[subSourceIDs[bit]] != SourceLayout::INVALID_SUB_SOURCE_ID_BIT) {
+			LOG_ERROR("The sourceSubID " << subSourceIDs[bit] << " is expected more than once");
+			exit(1);
+		}
+		layout.subIDToBit[subSourceIDs[bit]] = bit;
+		layout.bitToSubID.push_back(subSourceIDs[bit]);
+	}
+	return layout;
+}
+
+SourceLayout::SourceLayout(const uint32_t version, const uint_fast16_t timeStampSourceID,
+		const std::vector<std::pair<int, int> >& l0Sources,
+		const std::vector<std::pair<int, int> >& l1Sources) :
+		version(version), numberOfL0Sources(l0Sources.size()), numberOfL1Sources(
+				l1Sources.size()), largestL0SourceID(0), largestL1SourceID(0), expectedL0PacketsPerEvent(
+				0), expectedL1PacketsPerEvent(0), timeStampSourceNum(0), l0tpActive(false), references_(1) {
+	for (uint sourceID = 0; sourceID != 256; sourceID++) {
+		l0Descriptors[sourceID] = {0, 0xFF, 0};
+		l1Descriptors[sourceID] = {0, 0xFF, 0};
+	}
+
+	for (uint_fast8_t i = 0; i != numberOfL0Sources; i++) {
+		l0SourceIDs[i] = l0Sources[i].first;
+		l0PacketsBySourceNum[i] = l0Sources[i].second;
+		expectedL0PacketsPerEvent += l0Sources[i].second;
+		largestL0SourceID = std::max(largestL0SourceID, l0SourceIDs[i]);
+		l0Descriptors[l0SourceIDs[i]] = {1, (uint8_t) i, l0PacketsBySourceNum[i]};
+		l0SubSourceIDLayouts.push_back(SubSourceIDLayout());
+	}
+	for (uint_fast8_t i = 0; i != numberOfL1Sources; i++) {
+		l1SourceIDs[i] = l1Sources[i].first;
+		l1PacketsBySourceNum[i] = l1Sources[i].second;
+		expectedL1PacketsPerEvent += l1Sources[i].second;
+		largestL1SourceID = std::max(largestL1SourceID, l1SourceIDs[i]);
+		l1Descriptors[l1SourceIDs[i]] = {1, (uint8_t) i, l1PacketsBySourceNum[i]};
+		l1SubSourceIDLayouts.push_back(SubSourceIDLayout());
+	}
+
+#ifdef NA62_STATIC_SOURCE_LAYOUT
+	/*
+	 * The compiled in layout must match the configured one exactly
+	 */
+	bool matchesStaticLayout = numberOfL0Sources == StaticSourceLayout::NumberOfL0Sources
+			&& numberOfL1Sources == StaticSourceLayout::NumberOfL1Sources;
+	for (uint_fast8_t i = 0; matchesStaticLayout && i < numberOfL0Sources; i++) {
+		matchesStaticLayout = l0SourceIDs[i] == StaticSourceLayout::L0SourceIDs[i];
+	}
+	for (uint_fast8_t i = 0; matchesStaticLayout && i < numberOfL1Sources; i++) {
+		matchesStaticLayout = l1SourceIDs[i] == StaticSourceLayout::L1SourceIDs[i];
+	}
+	if (!matchesStaticLayout) {
+		LOG_ERROR("The configured sourceIDs differ from the ones compiled in with NA62_STATIC_SOURCE_LAYOUT. Rebuild without NA62_STATIC_SOURCE_LAYOUT or with matching NA62_STATIC_L0_SOURCE_IDS/NA62_STATIC_L1_SOURCE_IDS");
+		exit(1);
+	}
+#endif
+
+	l0tpActive = l0Descriptors[SOURCE_ID_L0TP].valid;
+	if (timeStampSourceID > 0xFF || !l0Descriptors[timeStampSourceID].valid) {
+		LOG_ERROR("The timestamp reference source ID is not part of the L0SourceIDs list");
+		exit(1);
+	}
+	timeStampSourceNum = l0Descriptors[timeStampSourceID].sourceNum;
+}
+
+SourceLayout::SourceLayout(const uint32_t version, const SourceLayout& other) :
+		version(version), numberOfL0Sources(other.numberOfL0Sources), numberOfL1Sources(
+				other.numberOfL1Sources), largestL0SourceID(other.largestL0SourceID), largestL1SourceID(
+				other.largestL1SourceID), expectedL0PacketsPerEvent(other.expectedL0PacketsPerEvent), expectedL1PacketsPerEvent(
+				other.expectedL1PacketsPerEvent), timeStampSourceNum(other.timeStampSourceNum), l0tpActive(
+				other.l0tpActive), l0SubSourceIDLayouts(other.l0SubSourceIDLayouts), l1SubSourceIDLayouts(
+				other.l1SubSourceIDLayouts), references_(1) {
+	std::copy(other.l0Descriptors, other.l0Descriptors + 256, l0Descriptors);
+	std::copy(other.l1Descriptors, other.l1Descriptors + 256, l1Descriptors);
+	std::copy(other.l0PacketsBySourceNum, other.l0PacketsBySourceNum + 256, l0PacketsBySourceNum);
+	std::copy(other.l1PacketsBySourceNum, other.l1PacketsBySourceNum + 256, l1PacketsBySourceNum);
+	std::copy(other.l0SourceIDs, other.l0SourceIDs + 256, l0SourceIDs);
+	std::copy(other.l1SourceIDs, other.l1SourceIDs + 256, l1SourceIDs);
+}
+
+void* SourceLayout::operator new(size_t size) {
+	void* ptr;
+	if (posix_memalign(&ptr, alignof(SourceLayout), size) != 0) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void SourceLayout::operator delete(void* ptr) {
+	free(ptr);
+}
+
+void SourceLayout::setSubSourceIDs(const bool isL1, const uint_fast8_t sourceNum,
+		const std::vector<uint_fast16_t>& subSourceIDs) {
+	if (isL1) {
+		l1SubSourceIDLayouts[sourceNum] = createSubSourceIDLayout(subSourceIDs);
+	} else {
+		l0SubSourceIDLayouts[sourceNum] = createSubSourceIDLayout(subSourceIDs);
+	}
+}
+
+bool SourceLayout::hasSameShape(const SourceLayout& other) const {
+	if (numberOfL0Sources != other.numberOfL0Sources || numberOfL1Sources != other.numberOfL1Sources) {
+		return false;
+	}
+	return std::equal(l0PacketsBySourceNum, l0PacketsBySourceNum + numberOfL0Sources,
+			other.l0PacketsBySourceNum)
+			&& std::equal(l1PacketsBySourceNum, l1PacketsBySourceNum + numberOfL1Sources,
+					other.l1PacketsBySourceNum);
+}
+
+} /* namespace na62 */
@@ -0,0 +1,131 @@
+/*
+ * SourceLayout.h
+ *
+ * Immutable snapshot of the source configuration: the participating L0 and L1 sourceIDs, their expected
+ * packets and sourceSubIDs. The SourceIDManager publishes one snapshot as the current layout. Every Event
+ * holds a reference to the snapshot it has been built with so that a new layout can be published between
+ * two bursts while old events are still around (see SourceIDManager::scheduleLayout). A snapshot is deleted
+ * as soon as the last reference has been released.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#pragma once
+#ifndef SOURCELAYOUT_H_
+#define SOURCELAYOUT_H_
+
+#include <sys/types.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+namespace na62 {
+
+class SourceLayout: private boost::noncopyable {
+public:
+	/*
+	 * Everything the fragment path needs to know about a sourceID packed into 4 bytes so that every lookup by
+	 * sourceID reads a single cache line
+	 */
+	struct SourceDescriptor {
+		uint8_t valid;
+		uint8_t sourceNum; // 0xFF if not valid
+		uint16_t expectedPackets;
+	};
+
+	/*
+	 * Maps the sourceSubIDs of one source to consecutive bit numbers used by the Subevents to mark received fragments.
+	 * Sources without configured sourceSubIDs (see SourceIDManager::setExpectedSubSourceIDs) have empty tables: their
+	 * Subevents accept any sourceSubID until the expected number of fragments has been received
+	 */
+	struct SubSourceIDLayout {
+		std::vector<uint16_t> subIDToBit; // INVALID_SUB_SOURCE_ID_BIT for unexpected sourceSubIDs
+		std::vector<uint16_t> bitToSubID;
+		bool configured;
+
+		SubSourceIDLayout() :
+				configured(false) {
+		}
+
+		inline uint_fast16_t getBit(const uint_fast16_t subSourceID) const {
+			return subSourceID < subIDToBit.size() ? subIDToBit[subSourceID] : INVALID_SUB_SOURCE_ID_BIT;
+		}
+	};
+
+	static const uint_fast16_t INVALID_SUB_SOURCE_ID_BIT = 0xFFFF;
+
+	/**
+	 * Builds the tables of the given configuration (see SourceIDManager::Initialize). The snapshot starts with
+	 * one reference owned by the caller. Exits if the configuration is invalid.
+	 */
+	SourceLayout(const uint32_t version, const uint_fast16_t timeStampSourceID,
+			const std::vector<std::pair<int, int> >& l0Sources,
+			const std::vector<std::pair<int, int> >& l1Sources);
+
+	/**
+	 * Copy of <other> with a new version, used to change the sourceSubIDs without touching a published snapshot.
+	 * The snapshot starts with one reference owned by the caller.
+	 */
+	SourceLayout(const uint32_t version, const SourceLayout& other);
+
+	static void* operator new(size_t size);
+	static void operator delete(void* ptr);
+
+	inline void acquire() const {
+		references_.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/*
+	 * Deletes the snapshot if this was the last reference
+	 */
+	inline void release() const {
+		if (references_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			delete this;
+		}
+	}
+
+	/**
+	 * Replaces the expected sourceSubIDs of a source. Only allowed before the snapshot is published
+	 */
+	void setSubSourceIDs(const bool isL1, const uint_fast8_t sourceNum,
+			const std::vector<uint_fast16_t>& subSourceIDs);
+
+	/**
+	 * True if both layouts have the same number of sources with the same number of expected packets at every
+	 * sourceNum. Events built for one of them can be used for the other one by updating their sourceIDs
+	 */
+	bool hasSameShape(const SourceLayout& other) const;
+
+	alignas(64) SourceDescriptor l0Descriptors[256]; // By sourceID
+	alignas(64) SourceDescriptor l1Descriptors[256]; // By sourceID
+	alignas(64) uint16_t l0PacketsBySourceNum[256];
+	alignas(64) uint16_t l1PacketsBySourceNum[256];
+	uint_fast8_t l0SourceIDs[256]; // By sourceNum
+	uint_fast8_t l1SourceIDs[256]; // By sourceNum
+
+	const uint32_t version;
+	uint_fast8_t numberOfL0Sources;
+	uint_fast8_t numberOfL1Sources;
+	uint_fast8_t largestL0SourceID;
+	uint_fast8_t largestL1SourceID;
+	uint_fast16_t expectedL0PacketsPerEvent;
+	uint_fast16_t expectedL1PacketsPerEvent;
+	uint_fast8_t timeStampSourceNum;
+	bool l0tpActive;
+
+	std::vector<SubSourceIDLayout> l0SubSourceIDLayouts; // By sourceNum
+	std::vector<SubSourceIDLayout> l1SubSourceIDLayouts; // By L1 sourceNum
+
+private:
+	~SourceLayout() {
+	}
+
+	mutable std::atomic<uint32_t> references_;
+};
+
+} /* namespace na62 */
+
+#endif /* SOURCELAYOUT_H_ */
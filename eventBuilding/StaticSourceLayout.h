@@ -0,0 +1,85 @@
+/*
+ * StaticSourceLayout.h
+ *
+ * Source layout known at compile time. Only used if NA62_STATIC_SOURCE_LAYOUT is defined: the
+ * SourceIDManager then maps sourceIDs known at compile time to constant sourceNums and iterations over all
+ * sources (forEachL0SourceNum/forEachL1SourceNum) are unrolled.
+ *
+ * The sourceIDs in sourceNum order default to the standard NA62 configuration and may be overridden with
+ * -DNA62_STATIC_L0_SOURCE_IDS=... and -DNA62_STATIC_L1_SOURCE_IDS=... The runtime configuration passed to
+ * SourceIDManager::Initialize must list the same sourceIDs in the same order. The number of packets per
+ * source remains configurable at runtime.
+ *
+ * Included by SourceIDManager.h after the SOURCE_ID_* definitions.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#pragma once
+#ifndef STATICSOURCELAYOUT_H_
+#define STATICSOURCELAYOUT_H_
+
+#include <cstdint>
+#include <type_traits>
+
+#ifndef NA62_STATIC_L0_SOURCE_IDS
+#define NA62_STATIC_L0_SOURCE_IDS SOURCE_ID_CEDAR, SOURCE_ID_GTK, SOURCE_ID_CHANTI, SOURCE_ID_LAV, \
+	SOURCE_ID_STRAW, SOURCE_ID_CHOD, SOURCE_ID_RICH, SOURCE_ID_IRC, SOURCE_ID_LKr, SOURCE_ID_MUV3, \
+	SOURCE_ID_SAC, SOURCE_ID_L0TP
+#endif
+
+#ifndef NA62_STATIC_L1_SOURCE_IDS
+#define NA62_STATIC_L1_SOURCE_IDS SOURCE_ID_LKr, SOURCE_ID_MUV1, SOURCE_ID_MUV2
+#endif
+
+namespace na62 {
+namespace StaticSourceLayout {
+
+constexpr uint_fast8_t L0SourceIDs[] = { NA62_STATIC_L0_SOURCE_IDS };
+constexpr uint_fast8_t L1SourceIDs[] = { NA62_STATIC_L1_SOURCE_IDS };
+
+constexpr uint_fast8_t NumberOfL0Sources = sizeof(L0SourceIDs) / sizeof(L0SourceIDs[0]);
+constexpr uint_fast8_t NumberOfL1Sources = sizeof(L1SourceIDs) / sizeof(L1SourceIDs[0]);
+
+/*
+ * Position of <sourceID> in <sourceIDs> starting at <sourceNum> or 0xFF if it is not listed
+ */
+constexpr uint_fast8_t findSourceNum(const uint_fast8_t* sourceIDs, const uint_fast8_t numberOfSources,
+		const uint_fast8_t sourceID, const uint_fast8_t sourceNum = 0) {
+	return sourceNum == numberOfSources ? 0xFF :
+			(sourceIDs[sourceNum] == sourceID ?
+					sourceNum : findSourceNum(sourceIDs, numberOfSources, sourceID, sourceNum + 1));
+}
+
+constexpr uint_fast8_t l0SourceIDToNum(const uint_fast8_t sourceID) {
+	return findSourceNum(L0SourceIDs, NumberOfL0Sources, sourceID);
+}
+
+constexpr uint_fast8_t l1SourceIDToNum(const uint_fast8_t sourceID) {
+	return findSourceNum(L1SourceIDs, NumberOfL1Sources, sourceID);
+}
+
+/*
+ * Calls function(sourceNum) for every sourceNum in [SourceNum, End) without a loop. The sourceNum is passed
+ * as std::integral_constant so that it is known at compile time after inlining
+ */
+template<uint_fast8_t SourceNum, uint_fast8_t End>
+struct ForEachSourceNum {
+	template<typename Function>
+	static inline void run(Function& function) {
+		function(std::integral_constant<uint_fast8_t, SourceNum>());
+		ForEachSourceNum<SourceNum + 1, End>::run(function);
+	}
+};
+
+template<uint_fast8_t End>
+struct ForEachSourceNum<End, End> {
+	template<typename Function>
+	static inline void run(Function&) {
+	}
+};
+
+} /* namespace StaticSourceLayout */
+} /* namespace na62 */
+
+#endif /* STATICSOURCELAYOUT_H_ */
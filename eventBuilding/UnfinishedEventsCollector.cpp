@@ -14,9 +14,11 @@
 
 namespace na62 {
 std::map<uint, std::map<uint, uint>> UnfinishedEventsCollector::receivedEventsBySubsourceBySourceID;
+std::mutex UnfinishedEventsCollector::mutex_;
 
 void UnfinishedEventsCollector::addReceivedSubSourceIdFromUnfinishedEvent(
 		uint sourceNum, uint subSourceID) {
+	std::lock_guard<std::mutex> lock(mutex_);
 	auto lb = receivedEventsBySubsourceBySourceID.lower_bound(sourceNum);
 	// Check if The sourceNum already exists
 	if (lb != receivedEventsBySubsourceBySourceID.end()
@@ -48,8 +50,21 @@ void UnfinishedEventsCollector::addReceivedSubSourceIdFromUnfinishedEvent(
 	}
 }
 
+void UnfinishedEventsCollector::addReceivedSubSourceIds(
+		const std::map<uint, std::map<uint, uint>>& receivedEventsBySubsourceBySourceNum) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	for (const auto& sourceAndData : receivedEventsBySubsourceBySourceNum) {
+		std::map<uint, uint>& subsourceAndData =
+				receivedEventsBySubsourceBySourceID[sourceAndData.first];
+		for (const auto& subsourceAndEventNum : sourceAndData.second) {
+			subsourceAndData[subsourceAndEventNum.first] += subsourceAndEventNum.second;
+		}
+	}
+}
+
 std::string UnfinishedEventsCollector::toJson() {
 	std::stringstream stream;
+	std::lock_guard<std::mutex> lock(mutex_);
 
 	stream << "{";
 
@@ -10,19 +10,31 @@
 
 #include <sys/types.h>
 #include <map>
+#include <mutex>
 #include <string>
 
 namespace na62 {
 
+/*
+ * Filled by the EventTimeoutHandler and EventPool::sweepUnfinishedEvents and read by the monitoring: all
+ * methods may be called concurrently
+ */
 class UnfinishedEventsCollector {
 public:
 	static void addReceivedSubSourceIdFromUnfinishedEvent(uint sourceNum,
 			uint subSourceID);
 
+	/*
+	 * Adds all counters of <receivedEventsBySubsourceBySourceNum> (sourceNum -> subSourceID -> count)
+	 */
+	static void addReceivedSubSourceIds(
+			const std::map<uint, std::map<uint, uint>>& receivedEventsBySubsourceBySourceNum);
+
 	static std::string toJson();
 
 private:
 	static std::map<uint, std::map<uint, uint>> receivedEventsBySubsourceBySourceID;
+	static std::mutex mutex_;
 };
 
 } /* namespace na62 */
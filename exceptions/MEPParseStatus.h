@@ -0,0 +1,135 @@
+/*
+ * MEPParseStatus.h
+ *
+ * Result of the validation of a received L0 or L1 MEP. This is the non-throwing counterpart of
+ * BrokenPacketReceivedError and UnknownSourceIDFound: it only stores a few numbers and the message
+ * is only built if somebody calls toString().
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#pragma once
+#ifndef MEPPARSESTATUS_H_
+#define MEPPARSESTATUS_H_
+
+#include <cstdint>
+#include <string>
+
+namespace na62 {
+
+enum class MEPParseError : uint8_t {
+	NONE = 0,
+	EMPTY_PACKET,
+	TRUNCATED_HEADER,
+	INCOMPLETE_MEP,
+	OVERLONG_MEP,
+	UNKNOWN_SOURCE_ID,
+	BAD_EVENT_NUMBER_LSB,
+	INCOMPLETE_FRAGMENT,
+	FRAGMENT_SUM_MISMATCH,
+	NUMBER_OF_ERRORS
+};
+
+struct MEPParseStatus {
+	MEPParseError error;
+	uint8_t sourceID;
+	uint16_t sourceSubID;
+	/*
+	 * Index of the fragment within the MEP in which the error has been detected
+	 */
+	uint16_t fragmentIndex;
+	/*
+	 * Meaning depends on <error>: lengths in bytes or the event number LSB
+	 */
+	uint32_t received;
+	uint32_t expected;
+
+	MEPParseStatus() :
+			error(MEPParseError::NONE), sourceID(0), sourceSubID(0), fragmentIndex(
+					0), received(0), expected(0) {
+	}
+
+	MEPParseStatus(MEPParseError _error, uint8_t _sourceID,
+			uint16_t _sourceSubID, uint16_t _fragmentIndex = 0,
+			uint32_t _received = 0, uint32_t _expected = 0) :
+			error(_error), sourceID(_sourceID), sourceSubID(_sourceSubID), fragmentIndex(
+					_fragmentIndex), received(_received), expected(_expected) {
+	}
+
+	inline bool isValid() const {
+		return error == MEPParseError::NONE;
+	}
+
+	static const char* errorToString(const MEPParseError error) {
+		switch (error) {
+		case MEPParseError::NONE:
+			return "None";
+		case MEPParseError::EMPTY_PACKET:
+			return "EmptyPacket";
+		case MEPParseError::TRUNCATED_HEADER:
+			return "TruncatedHeader";
+		case MEPParseError::INCOMPLETE_MEP:
+			return "IncompleteMEP";
+		case MEPParseError::OVERLONG_MEP:
+			return "OverlongMEP";
+		case MEPParseError::UNKNOWN_SOURCE_ID:
+			return "UnknownSourceID";
+		case MEPParseError::BAD_EVENT_NUMBER_LSB:
+			return "BadEventNumberLSB";
+		case MEPParseError::INCOMPLETE_FRAGMENT:
+			return "IncompleteFragment";
+		case MEPParseError::FRAGMENT_SUM_MISMATCH:
+			return "FragmentSumMismatch";
+		default:
+			return "Unknown";
+		}
+	}
+
+	/**
+	 * Human readable description of the error. Only call this on the error path
+	 */
+	std::string toString() const {
+		const std::string source = " (source ID " + std::to_string((int) sourceID)
+				+ ", board " + std::to_string((int) sourceSubID) + ")";
+		switch (error) {
+		case MEPParseError::NONE:
+			return "No error";
+		case MEPParseError::EMPTY_PACKET:
+			return "Received EMPTY UDP packet!";
+		case MEPParseError::TRUNCATED_HEADER:
+			return "Incomplete MEP! Size " + std::to_string(received)
+					+ " smaller than the header size "
+					+ std::to_string(expected);
+		case MEPParseError::INCOMPLETE_MEP:
+			return "Incomplete MEP! Received only " + std::to_string(received)
+					+ " of " + std::to_string(expected) + " bytes" + source;
+		case MEPParseError::OVERLONG_MEP:
+			return "Received MEP longer than 'mep length' field! Received "
+					+ std::to_string(received) + " instead of "
+					+ std::to_string(expected) + " bytes" + source;
+		case MEPParseError::UNKNOWN_SOURCE_ID:
+			return "Unknown source ID: " + std::to_string((int) sourceID)
+					+ " board " + std::to_string((int) sourceSubID)
+					+ "\n Check the corresponding field in the Options file!";
+		case MEPParseError::BAD_EVENT_NUMBER_LSB:
+			return "MEPFragment " + std::to_string(fragmentIndex)
+					+ " with bad event number LSB received: received "
+					+ std::to_string(received) + " but expected LSB is "
+					+ std::to_string(expected) + source;
+		case MEPParseError::INCOMPLETE_FRAGMENT:
+			return "Incomplete MEPFragment " + std::to_string(fragmentIndex)
+					+ "! Received only " + std::to_string(received) + " of "
+					+ std::to_string(expected) + " bytes" + source;
+		case MEPParseError::FRAGMENT_SUM_MISMATCH:
+			return "Sum of MEP events + MEP Header is smaller than expected: "
+					+ std::to_string(received) + " instead of "
+					+ std::to_string(expected) + source;
+		default:
+			return "Unknown error" + source;
+		}
+	}
+};
+
+} /* namespace na62 */
+
+#endif /* MEPPARSESTATUS_H_ */
@@ -10,6 +10,7 @@
 #include <netinet/in.h>
 #include <netinet/ip.h>
 #include <netinet/udp.h>
+#include <algorithm>
 #include <iostream>
 #include <new>
 #include <string>
@@ -17,56 +18,96 @@
 #include "../exceptions/CommonExceptions.h"
 #include "../exceptions/BrokenPacketReceivedError.h"
 #include "../exceptions/UnknownSourceIDFound.h"
+#include "../monitoring/MEPErrorStatistics.h"
 #include "../options/Options.h"
 #include "MEPFragment.h"
 
 namespace na62 {
 namespace l0 {
 
+bool MEP::useSlabAllocation_ = false;
+
+/*
+ * Size of the MEP object at the beginning of a slab, padded so that the fragment table is aligned
+ */
+static const size_t SlabHeaderSize = (sizeof(MEP) + alignof(MEPFragment*) - 1)
+		& ~(alignof(MEPFragment*) - 1);
+
 MEP::MEP(const char *data, const uint_fast16_t & dataLength,
 		const DataContainer originalData) :
-		originalData_(originalData), rawData_(reinterpret_cast<const MEP_HDR*>(data)), checkSumsVarified_(
+		originalData_(originalData), rawData_(reinterpret_cast<const MEP_HDR*>(data)), fragments_(
+				nullptr), fragmentStorage_(nullptr), ownsFragmentStorage_(false), checkSumsVarified_(
+		false) {
+	const MEPParseStatus status = validate(data, dataLength);
+	if (!status.isValid()) {
+		throwParseError(status);
+	}
+
+	if (useSlabAllocation_) {
+		fragmentStorage_ = new char[getFragmentStorageSize(rawData_->eventCount)];
+		ownsFragmentStorage_ = true;
+	}
+	initializeMEPFragments(data);
+}
+
+MEP::MEP(const char *data, const uint_fast16_t &,
+		const DataContainer originalData, char* fragmentStorage) :
+		originalData_(originalData), rawData_(reinterpret_cast<const MEP_HDR*>(data)), fragments_(
+				nullptr), fragmentStorage_(fragmentStorage), ownsFragmentStorage_(false), checkSumsVarified_(
 		false) {
+	initializeMEPFragments(data);
+}
+
+MEP* MEP::create(const char *data, const uint_fast16_t & dataLength,
+		const DataContainer originalData) {
+	const MEPParseStatus status = validate(data, dataLength);
+	if (!status.isValid()) {
+		throwParseError(status);
+	}
+	return allocate(data, dataLength, originalData);
+}
+
+MEP* MEP::create(const char *data, const uint_fast16_t & dataLength,
+		const DataContainer originalData, MEPParseStatus& status) {
+	status = validate(data, dataLength);
+	if (!status.isValid()) {
+		MEPErrorStatistics::reportL0Error(status, data, dataLength);
+		return nullptr;
+	}
+	return allocate(data, dataLength, originalData);
+}
+
+MEP* MEP::allocate(const char *data, const uint_fast16_t & dataLength,
+		const DataContainer originalData) {
+	if (!useSlabAllocation_) {
+		return new MEP(data, dataLength, originalData, nullptr);
+	}
+
+	const uint_fast8_t eventCount = reinterpret_cast<const MEP_HDR*>(data)->eventCount;
+	char* slab = static_cast<char*>(::operator new(
+			SlabHeaderSize + getFragmentStorageSize(eventCount)));
+	return new (slab) MEP(data, dataLength, originalData, slab + SlabHeaderSize);
+}
+
+size_t MEP::getFragmentStorageSize(const uint_fast8_t eventCount) {
+	const size_t tableSize = (eventCount * sizeof(MEPFragment*) + alignof(MEPFragment) - 1)
+			& ~(alignof(MEPFragment) - 1);
+	return tableSize + eventCount * sizeof(MEPFragment);
+}
 
+MEPParseStatus MEP::validate(const char *data,
+		const uint_fast16_t & dataLength) {
 	if (dataLength < sizeof(MEP_HDR)) {
-#ifdef USE_ERS
-		std::ostringstream s;
-		s << "Incomplete MEP! Size " << dataLength << " smaller than MEP_HDR!";
-		throw CorruptedMEP(ERS_HERE, s.str());
-#else
-		throw BrokenPacketReceivedError(
-							"type = BadEv : Incomplete MEP! Size " + std::to_string(dataLength) + " smaller than MEP_HDR!"
-									+ std::to_string(dataLength) + " of "
-									+ std::to_string(getLength()) + " bytes");
-#endif
+		return MEPParseStatus(MEPParseError::TRUNCATED_HEADER, 0, 0, 0,
+				dataLength, sizeof(MEP_HDR));
 	}
-	fragments_ = new MEPFragment*[rawData_->eventCount];
-	if (getLength() != dataLength) {
-		if (getLength() > dataLength) {
-#ifdef USE_ERS
-			std::ostringstream s;
-			s<< "BadEv : Incomplete MEP! Received only " << dataLength << " of " << getLength() << " bytes";
-			throw CorruptedMEP(ERS_HERE, s.str());
-#else
-			throw BrokenPacketReceivedError(
-					"type = BadEv : Incomplete MEP! Received only "
-							+ std::to_string(dataLength) + " of "
-							+ std::to_string(getLength()) + " bytes");
-#endif
-		} else {
-#ifdef USE_ERS
-			std::ostringstream s;
-			s << "Received MEP longer than 'mep length' field! Received "
-			  << dataLength << " instead of " << getLength() <<  " bytes";
-			throw CorruptedMEP(ERS_HERE, s.str());
-#else
-			throw BrokenPacketReceivedError(
-					"type = BadEv : Received MEP longer than 'mep length' field! Received "
-							+ std::to_string(dataLength) + " instead of "
-							+ std::to_string(getLength()) + " bytes");
-#endif
-		}
+	const MEP_HDR* hdr = reinterpret_cast<const MEP_HDR*>(data);
 
+	if (hdr->mepLength != dataLength) {
+		return MEPParseStatus(
+				hdr->mepLength > dataLength ?
+						MEPParseError::INCOMPLETE_MEP : MEPParseError::OVERLONG_MEP,
+				hdr->sourceID, hdr->sourceSubID, 0, dataLength, hdr->mepLength);
 	}
 
 	/*
@@ -74,14 +115,72 @@ MEP::MEP(const char *data, const uint_fast16_t & dataLength,
 	 *
 	 * TODO: Do we need to check the sourceID? This is quite expensive!
 	 */
-	if (!SourceIDManager::checkL0SourceID(getSourceID())) {
+	if (!SourceIDManager::checkL0SourceID(hdr->sourceID)) {
+		return MEPParseStatus(MEPParseError::UNKNOWN_SOURCE_ID, hdr->sourceID,
+				hdr->sourceSubID);
+	}
+
+	// The first subevent starts directly after the header -> offset is 12
+	uint_fast32_t offset = sizeof(MEP_HDR);
+	uint_fast32_t expectedEventNum = hdr->firstEventNum;
+	for (uint_fast16_t i = 0; i != hdr->eventCount; i++) {
+		if (offset + sizeof(MEPFragment_HDR) > dataLength) {
+			return MEPParseStatus(MEPParseError::INCOMPLETE_FRAGMENT,
+					hdr->sourceID, hdr->sourceSubID, i, dataLength,
+					offset + sizeof(MEPFragment_HDR));
+		}
+		const MEPFragment_HDR* fragment =
+				reinterpret_cast<const MEPFragment_HDR*>(data + offset);
+
+		/*
+		 * Cite from NA62-11-02:
+		 * Event number LSB: the least significant 16 bits of the event number, as defined inside the
+		 * transmitter by the number of L0 triggers received since the start of the burst; the most
+		 * significant 8 bits are obtained from the MEP header. For the first event in the MEP, this field
+		 * will match the lower 16 bits of the first word in the MEP header; since all sub-systems in global
+		 * mode must respond to all L0 triggers, for each following event in the MEP, this number should
+		 * increase by one, possibly wrapping around to zero (in which case the upper 8 bits of the event
+		 * number are those in the MEP header incremented by one).
+		 */
+		if (fragment->eventNumberLSB_ != (expectedEventNum & 0x000000FF)) {
+			return MEPParseStatus(MEPParseError::BAD_EVENT_NUMBER_LSB,
+					hdr->sourceID, hdr->sourceSubID, i,
+					fragment->eventNumberLSB_, expectedEventNum & 0x000000FF);
+		}
+
+		if (fragment->eventLength_ < sizeof(MEPFragment_HDR)
+				|| fragment->eventLength_ + offset > dataLength) {
+			return MEPParseStatus(MEPParseError::INCOMPLETE_FRAGMENT,
+					hdr->sourceID, hdr->sourceSubID, i, dataLength,
+					offset + std::max<uint_fast32_t>(fragment->eventLength_,
+							sizeof(MEPFragment_HDR)));
+		}
+		offset += fragment->eventLength_;
+		expectedEventNum++;
+	}
+
+	// Check if too many bytes have been transmitted
+	if (offset < dataLength) {
+		return MEPParseStatus(MEPParseError::FRAGMENT_SUM_MISMATCH,
+				hdr->sourceID, hdr->sourceSubID, hdr->eventCount, offset,
+				dataLength);
+	}
+	return MEPParseStatus();
+}
+
+void MEP::throwParseError(const MEPParseStatus& status) {
+	if (status.error == MEPParseError::UNKNOWN_SOURCE_ID) {
 #ifdef USE_ERS
-		throw UnknownSourceID(ERS_HERE, getSourceID(), getSourceSubID());
+		throw UnknownSourceID(ERS_HERE, status.sourceID, status.sourceSubID);
 #else
-		throw UnknownSourceIDFound(getSourceID(), getSourceSubID());
+		throw UnknownSourceIDFound(status.sourceID, status.sourceSubID);
 #endif
 	}
-	initializeMEPFragments(data, dataLength);
+#ifdef USE_ERS
+	throw CorruptedMEP(ERS_HERE, status.toString());
+#else
+	throw BrokenPacketReceivedError("type = BadEv : " + status.toString());
+#endif
 }
 
 MEP::~MEP() {
@@ -95,61 +194,54 @@ MEP::~MEP() {
 #endif;
 
 	}
-	delete[] fragments_;
+	if (fragmentStorage_ == nullptr) {
+		delete[] fragments_;
+	} else if (ownsFragmentStorage_) {
+		/*
+		 * If this MEP has been created by create() the fragment storage is released together with this object
+		 */
+		delete[] fragmentStorage_;
+	}
 	originalData_.free(); // Here we free the most important buffer used for polling in Receiver.cpp
 }
 
-void MEP::initializeMEPFragments(const char * data,
-	//const uint_fast16_t& dataLength) throw (BrokenPacketReceivedError) {
-		const uint_fast16_t& dataLength) {
+void MEP::initializeMEPFragments(const char * data) {
+	/*
+	 * The MEP has been checked by validate() already
+	 */
+
 	// The first subevent starts directly after the header -> offset is 12
 	uint_fast16_t offset = sizeof(MEP_HDR);
 
 	MEPFragment* newMEPFragment;
 	uint_fast32_t expectedEventNum = getFirstEventNum();
 
+	/*
+	 * With slab allocation the fragment table is followed directly by the MEPFragment objects
+	 */
+	MEPFragment* fragmentSlots = nullptr;
+	if (fragmentStorage_ != nullptr) {
+		fragments_ = reinterpret_cast<MEPFragment**>(fragmentStorage_);
+		fragmentSlots = reinterpret_cast<MEPFragment*>(fragmentStorage_
+				+ getFragmentStorageSize(rawData_->eventCount)
+				- rawData_->eventCount * sizeof(MEPFragment));
+	} else {
+		fragments_ = new MEPFragment*[rawData_->eventCount];
+	}
+
 	for (uint_fast16_t i = 0; i < getNumberOfFragments(); i++) {
-		/*
-		 *  Throws exception if the event number LSB has an unexpected value
-		 */
-		newMEPFragment = new MEPFragment(this,
-				(MEPFragment_HDR*) (data + offset), expectedEventNum);
+		if (fragmentSlots != nullptr) {
+			newMEPFragment = new (fragmentSlots + i) MEPFragment(this,
+					(MEPFragment_HDR*) (data + offset), expectedEventNum);
+		} else {
+			newMEPFragment = new MEPFragment(this,
+					(MEPFragment_HDR*) (data + offset), expectedEventNum);
+		}
 
 		expectedEventNum++;
 		fragments_[i] = newMEPFragment;
-		if (newMEPFragment->getDataWithHeaderLength() + offset > dataLength) {
-#ifdef USE_ERS
-			std::ostringstream s;
-			s << "Incomplete MEPFragment! Received only " << dataLength << " of "
-			  << offset + newMEPFragment->getDataWithHeaderLength() << " bytes";
-			throw CorruptedMEP(ERS_HERE, s.str());
-#else
-			throw BrokenPacketReceivedError(
-					"type = BadEv : Incomplete MEPFragment! Received only "
-							+ std::to_string(dataLength) + " of "
-							+ std::to_string(
-									offset
-											+ newMEPFragment->getDataWithHeaderLength())
-							+ " bytes");
-#endif
-			}
 		offset += newMEPFragment->getDataWithHeaderLength();
 	}
-
-	// Check if too many bytes have been transmitted
-	if (offset < dataLength) {
-#ifdef USE_ERS
-		std::ostringstream s;
-		s << "Sum of MEP events + MEP Header is smaller than expected: " << offset << " instead of " << dataLength;
-		throw CorruptedMEP(ERS_HERE, s.str());
-#else
-		throw BrokenPacketReceivedError(
-				"type = BadEv : Sum of MEP events + MEP Header is smaller than expected: "
-						+ std::to_string(offset) + " instead of "
-						+ std::to_string(dataLength));
-#endif
-
-	}
 	eventCount_ = rawData_->eventCount;
 }
 
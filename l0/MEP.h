@@ -15,6 +15,7 @@
 
 #include "../eventBuilding/SourceIDManager.h"
 #include "../exceptions/BrokenPacketReceivedError.h"
+#include "../exceptions/MEPParseStatus.h"
 #include "../exceptions/UnknownSourceIDFound.h"
 #include "../structs/DataContainer.h"
 
@@ -53,15 +54,64 @@ public:
 	MEP(const char *data, const uint_fast16_t & dataLength,
 			const DataContainer originalData) ;
 
+	/**
+	 * Creates a new MEP. If slab allocation is active the MEP, its fragment table and all its MEPFragments are
+	 * placed in one single memory block sized from MEP_HDR::eventCount. This block is freed in one step as soon
+	 * as the last MEPFragment has been released (see MEPFragment::release).
+	 *
+	 * Without slab allocation this is the same as <new MEP(data, dataLength, originalData)>
+	 */
+	static MEP* create(const char *data, const uint_fast16_t & dataLength,
+			const DataContainer originalData);
+
+	/**
+	 * Same as create() but does not throw if the MEP is broken. Instead nullptr is returned, <status> describes
+	 * the error and the MEPErrorStatistics are updated. In this case the caller still owns <originalData>.
+	 */
+	static MEP* create(const char *data, const uint_fast16_t & dataLength,
+			const DataContainer originalData, MEPParseStatus& status);
+
+	/**
+	 * Checks the MEP header and all MEPFragment headers without allocating anything
+	 */
+	static MEPParseStatus validate(const char *data,
+			const uint_fast16_t & dataLength);
+
 	/**
 	 * Frees the data buffer (orignialData) that was created by the Receiver
 	 *
-	 * Should only be called by ~MEPFragment() as a MEP may not be deleted until every MEPFragment is processed and deleted.
+	 * Should only be called by MEPFragment::release() as a MEP may not be deleted until every MEPFragment is processed and released.
 	 */
 	virtual ~MEP();
 
-	void initializeMEPFragments(const char* data,
-			const uint_fast16_t& dataLength) ;
+	/**
+	 * The MEP may be placed at the beginning of a slab -> always release the whole block
+	 */
+	static void operator delete(void* ptr) {
+		::operator delete(ptr);
+	}
+
+	/**
+	 * Activates or deactivates the slab allocation of MEPFragments for all MEPs created afterwards. Every MEP
+	 * remembers how its fragments have been allocated so the mode may be changed at any time.
+	 */
+	static void setSlabAllocation(const bool useSlabAllocation) {
+		useSlabAllocation_ = useSlabAllocation;
+	}
+
+	static inline bool isSlabAllocationActive() {
+		return useSlabAllocation_;
+	}
+
+	void initializeMEPFragments(const char* data);
+
+	/**
+	 * True if the MEPFragments are placed in the fragment storage of this MEP instead of being allocated
+	 * one by one
+	 */
+	inline bool hasFragmentStorage() const {
+		return fragmentStorage_ != nullptr;
+	}
 
 	/**
 	 * Returns a pointer to the n'th event within this MEP where 0<=n<getFirstEventNum()
@@ -147,6 +197,26 @@ public:
 //	bool verifyChecksums();
 
 private:
+	/**
+	 * Used by create() after validate(). If <fragmentStorage> is not nullptr the fragment table and all
+	 * MEPFragments are placed into it
+	 */
+	MEP(const char *data, const uint_fast16_t & dataLength,
+			const DataContainer originalData, char* fragmentStorage);
+
+	/**
+	 * Allocates an already validated MEP
+	 */
+	static MEP* allocate(const char *data, const uint_fast16_t & dataLength,
+			const DataContainer originalData);
+
+	/**
+	 * Number of bytes needed to store the fragment table and <eventCount> MEPFragments
+	 */
+	static size_t getFragmentStorageSize(const uint_fast8_t eventCount);
+
+	static void throwParseError(const MEPParseStatus& status);
+
 	std::atomic<int> eventCount_;
 
 	// The whole Ethernet frame
@@ -157,7 +227,19 @@ private:
 
 	MEPFragment **fragments_;
 
+	/*
+	 * Memory storing the fragment table followed by all MEPFragments if slab allocation is active. nullptr otherwise
+	 */
+	char* fragmentStorage_;
+
+	/*
+	 * True if fragmentStorage_ has been allocated separately and not together with this MEP by create()
+	 */
+	bool ownsFragmentStorage_;
+
 	bool checkSumsVarified_;
+
+	static bool useSlabAllocation_;
 };
 
 } /* namespace l2 */
@@ -35,7 +35,13 @@ class MEPFragment: private boost::noncopyable {
 public:
 	MEPFragment(MEP* mep, const MEPFragment_HDR * data,
 			uint_fast32_t& expectedEventNum);
-	virtual ~MEPFragment();
+
+	/**
+	 * Destroys this fragment and frees its MEP together with the received data as soon as all fragments of
+	 * the MEP are released. Must be used instead of delete: fragments of a MEP with fragment storage
+	 * (see MEP::create) are not allocated separately
+	 */
+	void release();
 
 	/**
 	 * Number of Bytes of the data including the header (sizeof MEPFragment_HDR)
@@ -92,6 +98,11 @@ public:
 		return mep_;
 	}
 private:
+	/*
+	 * Only called by release()
+	 */
+	virtual ~MEPFragment();
+
 	MEP* mep_;
 	const MEPFragment_HDR * rawData;
 
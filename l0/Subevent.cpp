@@ -14,24 +14,50 @@
 namespace na62 {
 namespace l0 {
 
-Subevent::Subevent(const uint_fast16_t expectedPacketsNum, const uint_fast8_t sourceID) :
-		expectedPacketsNum(expectedPacketsNum), sourceID(sourceID), eventFragments(
-				new (std::nothrow) MEPFragment*[expectedPacketsNum]), fragmentCounter(
-				0) {
+Subevent::Subevent(const uint_fast16_t expectedPacketsNum, const SourceLayout& layout,
+		const uint_fast8_t sourceNum) :
+		expectedPacketsNum(expectedPacketsNum), sourceID(
+				SourceIDManager::sourceNumToID(layout, sourceNum)), sourceNum(sourceNum), subSourceIDLayout(
+				&layout.l0SubSourceIDLayouts[sourceNum]), numberOfBitmapWords(
+				getNumberOfBitmapWords(expectedPacketsNum)), ownsEventFragments(true), eventFragments(
+				new (std::nothrow) MEPFragment*[expectedPacketsNum]), receivedSubIDs(
+				new std::atomic<uint64_t>[numberOfBitmapWords]), fragmentCounter(0) {
+	for (uint_fast16_t word = 0; word != numberOfBitmapWords; word++) {
+		receivedSubIDs[word] = 0;
+	}
+}
+
+Subevent::Subevent(const uint_fast16_t expectedPacketsNum, const SourceLayout& layout,
+		const uint_fast8_t sourceNum,
+		MEPFragment** eventFragments, std::atomic<uint64_t>* receivedSubIDs) :
+		expectedPacketsNum(expectedPacketsNum), sourceID(
+				SourceIDManager::sourceNumToID(layout, sourceNum)), sourceNum(sourceNum), subSourceIDLayout(
+				&layout.l0SubSourceIDLayouts[sourceNum]), numberOfBitmapWords(
+				getNumberOfBitmapWords(expectedPacketsNum)), ownsEventFragments(false), eventFragments(
+				eventFragments), receivedSubIDs(receivedSubIDs), fragmentCounter(0) {
+	for (uint_fast16_t word = 0; word != numberOfBitmapWords; word++) {
+		new (&receivedSubIDs[word]) std::atomic<uint64_t>(0);
+	}
 }
 
 Subevent::~Subevent() {
 //	throw NA62Error("A Subevent-Object should not be deleted! Use Subevent::destroy instead so that it can be reused by the overlaying Event!");
 	destroy();
-	delete[] eventFragments;
+	if (ownsEventFragments) {
+		delete[] eventFragments;
+		delete[] receivedSubIDs;
+	}
 }
 
 void Subevent::destroy() {
 	for (int i = 0; i != fragmentCounter; i++) {
-		delete eventFragments[i];
+		eventFragments[i]->release();
 		eventFragments[i] = nullptr;
 	}
 	fragmentCounter = 0;
+	for (uint_fast16_t word = 0; word != numberOfBitmapWords; word++) {
+		receivedSubIDs[word].store(0, std::memory_order_relaxed);
+	}
 }
 } /* namespace l0 */
 } /* namespace na62 */
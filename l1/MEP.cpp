@@ -8,12 +8,12 @@
 
 #include "MEP.h"
 
-#include <boost/lexical_cast.hpp>
 #include <string>
 
 #include "../exceptions/CommonExceptions.h"
 #include "../exceptions/BrokenPacketReceivedError.h"
 #include "../exceptions/UnknownSourceIDFound.h"
+#include "../monitoring/MEPErrorStatistics.h"
 
 namespace na62 {
 namespace l1 {
@@ -27,9 +27,85 @@ MEP::MEP(const char * data, const uint16_t& dataLength,
          * find out how many of those are written into this packet.
          */
 	eventNum_ = 0 ;
+	const MEPParseStatus status = validate(data, dataLength);
+	if (!status.isValid()) {
+		throwParseError(status);
+	}
+	initializeMEPFragments(data, dataLength);
+}
+
+MEP::MEP(const char * data, const uint16_t& dataLength,
+                DataContainer etherFrame, const MEPParseStatus&) :
+                dataContainer_(etherFrame), sourceID_(0xff) {
+	eventNum_ = 0 ;
 	initializeMEPFragments(data, dataLength);
 }
 
+MEP* MEP::create(const char * data, const uint16_t& dataLength,
+                DataContainer originalData, MEPParseStatus& status) {
+	status = validate(data, dataLength);
+	if (!status.isValid()) {
+		MEPErrorStatistics::reportL1Error(status, data, dataLength);
+		return nullptr;
+	}
+	return new MEP(data, dataLength, originalData, status);
+}
+
+MEPParseStatus MEP::validate(const char * data, const uint16_t& dataLength) {
+	if (dataLength == 0) {
+		return MEPParseStatus(MEPParseError::EMPTY_PACKET, 0, 0);
+	}
+	if (dataLength < sizeof(L1_EVENT_RAW_HDR)) {
+		return MEPParseStatus(MEPParseError::TRUNCATED_HEADER, 0, 0, 0,
+				dataLength, sizeof(L1_EVENT_RAW_HDR));
+	}
+	// Get source ID from first fragment and check its validity
+	const L1_EVENT_RAW_HDR* hdr = (const L1_EVENT_RAW_HDR*) (data);
+	if (!SourceIDManager::checkL1SourceID(hdr->sourceID)) {
+		return MEPParseStatus(MEPParseError::UNKNOWN_SOURCE_ID, hdr->sourceID,
+				hdr->sourceSubID);
+	}
+
+	uint_fast32_t offset = 0;
+	for (uint16_t fragmentIndex = 0; offset < dataLength; fragmentIndex++) {
+		if (offset + sizeof(L1_EVENT_RAW_HDR) > dataLength) {
+			return MEPParseStatus(MEPParseError::INCOMPLETE_FRAGMENT,
+					hdr->sourceID, hdr->sourceSubID, fragmentIndex, dataLength,
+					offset + sizeof(L1_EVENT_RAW_HDR));
+		}
+		const L1_EVENT_RAW_HDR* fragment =
+				(const L1_EVENT_RAW_HDR*) (data + offset);
+		const uint_fast32_t fragmentLength = fragment->numberOf4BWords * 4;
+
+		/*
+		 * A fragment shorter than its header would make us loop forever
+		 */
+		if (fragmentLength < sizeof(L1_EVENT_RAW_HDR)
+				|| fragmentLength + offset > dataLength) {
+			return MEPParseStatus(MEPParseError::INCOMPLETE_FRAGMENT,
+					hdr->sourceID, hdr->sourceSubID, fragmentIndex, dataLength,
+					offset + fragmentLength);
+		}
+		offset += fragmentLength;
+	}
+	return MEPParseStatus();
+}
+
+void MEP::throwParseError(const MEPParseStatus& status) {
+	if (status.error == MEPParseError::UNKNOWN_SOURCE_ID) {
+#ifdef USE_ERS
+		throw UnknownSourceID(ERS_HERE, status.sourceID, status.sourceSubID);
+#else
+		throw UnknownSourceIDFound(status.sourceID, status.sourceSubID);
+#endif
+	}
+#ifdef USE_ERS
+	throw CorruptedMEP(ERS_HERE, status.toString());
+#else
+	throw BrokenPacketReceivedError("type = BadEv : " + status.toString());
+#endif
+}
+
 MEP::~MEP() {
         if (eventNum_ != 0) {
                 /*
@@ -45,33 +121,10 @@ MEP::~MEP() {
 }
 
 void MEP::initializeMEPFragments(const char * data, const uint16_t& dataLength) {
-	if(dataLength == 0) {
-#ifdef USE_ERS
-		throw CorruptedMEP(ERS_HERE, "Received EMPTY UDP packet!");
-#else
-		throw BrokenPacketReceivedError("Received EMPTY UDP packet!");
-#endif
-	}
-	if(dataLength < sizeof(L1_EVENT_RAW_HDR)) {
-#ifdef USE_ERS
-		std::ostringstream s;
-		s << "Received UDP packet with size " << dataLength << " less data than a single L1 header!";
-		throw CorruptedMEP(ERS_HERE, s.str());
-#else
-		throw BrokenPacketReceivedError("Received UDP packet with less data than a single L1 header!");
-#endif
-	}
-	// Get source ID from first fragment and check its validity
+	/*
+	 * The MEP has been checked by validate() already
+	 */
 	const L1_EVENT_RAW_HDR* hdr = (const L1_EVENT_RAW_HDR*)(data);
-
-	if (!SourceIDManager::checkL1SourceID(hdr->sourceID)) {
-#ifdef USE_ERS
-		throw UnknownSourceID(ERS_HERE, hdr->sourceID, hdr->sourceSubID);
-#else
-		throw UnknownSourceIDFound(hdr->sourceID, hdr->sourceSubID);
-#endif
-	}
-
 	sourceID_ = hdr->sourceID;
 
 	uint16_t offset = 0;
@@ -80,16 +133,6 @@ void MEP::initializeMEPFragments(const char * data, const uint16_t& dataLength)
 
 	while (offset < dataLength) {
 		newEvent = new MEPFragment(this, (const L1_EVENT_RAW_HDR*)(data + offset));
-
-		if (newEvent->getEventLength() + offset > dataLength) {
-			throw BrokenPacketReceivedError(
-					"type = BadEv : Incomplete MEPFragment! Received only  "
-					+ boost::lexical_cast<std::string>(dataLength)
-					+ " instead of "
-					+ boost::lexical_cast<std::string>(
-							offset + newEvent->getEventLength())
-							+ " bytes");
-		}
 		offset += newEvent->getEventLength();
 		events.push_back(std::move(newEvent));
 	}
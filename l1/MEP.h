@@ -17,6 +17,7 @@
 
 #include "../exceptions/UnknownCREAMSourceIDFound.h"
 #include "../exceptions/BrokenPacketReceivedError.h"
+#include "../exceptions/MEPParseStatus.h"
 #include "../structs/DataContainer.h"
 #include "../eventBuilding/SourceIDManager.h"
 #include "MEPFragment.h"
@@ -32,6 +33,18 @@ public:
         MEP(const char * data, const uint16_t& dataLength,
                         DataContainer originalData) ;
 
+        /**
+         * Non-throwing alternative to the constructor: Returns nullptr if the MEP is broken. In this case
+         * <status> describes the error, the MEPErrorStatistics are updated and the caller still owns <originalData>.
+         */
+        static MEP* create(const char * data, const uint16_t& dataLength,
+                        DataContainer originalData, MEPParseStatus& status);
+
+        /**
+         * Checks all MEPFragment headers without allocating anything
+         */
+        static MEPParseStatus validate(const char * data, const uint16_t& dataLength);
+
         /**
          * Frees the data buffer (orignialData) that was created by the Receiver
          *
@@ -90,6 +103,14 @@ public:
         }
 
 private:
+    /**
+     * Used by create() after validate()
+     */
+    MEP(const char * data, const uint16_t& dataLength,
+                    DataContainer originalData, const MEPParseStatus& validStatus);
+
+    static void throwParseError(const MEPParseStatus& status);
+
     // The whole ethernet frame
     DataContainer dataContainer_;
     // Pointers to the payload of the UDP packet
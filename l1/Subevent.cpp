@@ -16,16 +16,39 @@
 namespace na62 {
 namespace l1 {
 
-Subevent::Subevent(const uint_fast16_t expectedPacketsNum, const uint_fast8_t sourceID) :
-		expectedPacketsNum(expectedPacketsNum), sourceID(sourceID), eventFragments(
-				new (std::nothrow) MEPFragment*[expectedPacketsNum]), fragmentCounter(
-				0) {
+Subevent::Subevent(const uint_fast16_t expectedPacketsNum, const SourceLayout& layout,
+		const uint_fast8_t sourceNum) :
+		expectedPacketsNum(expectedPacketsNum), sourceID(
+				SourceIDManager::l1SourceNumToID(layout, sourceNum)), sourceNum(sourceNum), subSourceIDLayout(
+				&layout.l1SubSourceIDLayouts[sourceNum]), numberOfBitmapWords(
+				getNumberOfBitmapWords(expectedPacketsNum)), ownsEventFragments(true), eventFragments(
+				new (std::nothrow) MEPFragment*[expectedPacketsNum]), receivedSubIDs(
+				new std::atomic<uint64_t>[numberOfBitmapWords]), fragmentCounter(0) {
+	for (uint_fast16_t word = 0; word != numberOfBitmapWords; word++) {
+		receivedSubIDs[word] = 0;
+	}
+}
+
+Subevent::Subevent(const uint_fast16_t expectedPacketsNum, const SourceLayout& layout,
+		const uint_fast8_t sourceNum,
+		MEPFragment** eventFragments, std::atomic<uint64_t>* receivedSubIDs) :
+		expectedPacketsNum(expectedPacketsNum), sourceID(
+				SourceIDManager::l1SourceNumToID(layout, sourceNum)), sourceNum(sourceNum), subSourceIDLayout(
+				&layout.l1SubSourceIDLayouts[sourceNum]), numberOfBitmapWords(
+				getNumberOfBitmapWords(expectedPacketsNum)), ownsEventFragments(false), eventFragments(
+				eventFragments), receivedSubIDs(receivedSubIDs), fragmentCounter(0) {
+	for (uint_fast16_t word = 0; word != numberOfBitmapWords; word++) {
+		new (&receivedSubIDs[word]) std::atomic<uint64_t>(0);
+	}
 }
 
 Subevent::~Subevent() {
-	throw NA62Error("A L1Subevent-Object should not be deleted! Use L1Subevent::destroy instead so that it can be reused by the overlaying Event!");
+//	throw NA62Error("A L1Subevent-Object should not be deleted! Use L1Subevent::destroy instead so that it can be reused by the overlaying Event!");
 	destroy();
-	delete[] eventFragments;
+	if (ownsEventFragments) {
+		delete[] eventFragments;
+		delete[] receivedSubIDs;
+	}
 }
 
 void Subevent::destroy() {
@@ -34,6 +57,9 @@ void Subevent::destroy() {
 		eventFragments[i] = nullptr;
 	}
 	fragmentCounter = 0;
+	for (uint_fast16_t word = 0; word != numberOfBitmapWords; word++) {
+		receivedSubIDs[word].store(0, std::memory_order_relaxed);
+	}
 }
 
 }
@@ -14,7 +14,7 @@
 #include <cstdbool>
 #include <cstdint>
 #include <iostream>
-#include <set>
+#include <vector>
 
 #include "../eventBuilding/SourceIDManager.h"
 #include "MEPFragment.h"
@@ -24,31 +24,62 @@ namespace l1 {
 
 class Subevent: private boost::noncopyable {
 public:
-	Subevent(const uint_fast16_t expectedPacketsNum, const uint_fast8_t sourceID);
+	/**
+	 * Subevent of the source <sourceNum> of <layout>. The layout must outlive the Subevent (the owning Event keeps
+	 * a reference to it)
+	 */
+	Subevent(const uint_fast16_t expectedPacketsNum, const SourceLayout& layout, const uint_fast8_t sourceNum);
+
+	/**
+	 * Uses <eventFragments> with space for <expectedPacketsNum> pointers to store the received fragments and
+	 * <receivedSubIDs> with space for getNumberOfBitmapWords(expectedPacketsNum) words to mark the received sourceSubIDs.
+	 * The memory is owned by the caller (see Event::initialize)
+	 */
+	Subevent(const uint_fast16_t expectedPacketsNum, const SourceLayout& layout, const uint_fast8_t sourceNum,
+			MEPFragment** eventFragments, std::atomic<uint64_t>* receivedSubIDs);
 	virtual ~Subevent();
 
 	void destroy();
 
 	/**
-	 * If the Subevent is not complete yet the given fragment will be stored and true is returned.
+	 * If the sourceSubID of the fragment is expected and has not been received yet the given fragment will be
+	 * stored and true is returned.
 	 *
-	 * Otherwise false is returned
+	 * Otherwise (duplicate or unknown sourceSubID) false is returned
 	 *
+	 * If the sourceSubIDs of the source are not configured any fragment is stored until the expected number of
+	 * fragments has been received
 	 */
 	inline bool addFragment(MEPFragment* fragment) {
-		uint_fast16_t oldNumberOfFragments = fragmentCounter.fetch_add(1);
-
-		if (oldNumberOfFragments
-				>= SourceIDManager::getExpectedL1PacksBySourceID(fragment->getSourceID())) {
+		if (!subSourceIDLayout->configured) {
+			uint_fast16_t oldNumberOfFragments = fragmentCounter.fetch_add(1);
+			if (oldNumberOfFragments >= expectedPacketsNum) {
+				fragmentCounter--;
+				return false;
+			}
+			eventFragments[oldNumberOfFragments] = fragment;
 			/*
-			 * when more fragments are received than expected: decrement the counter back to the old value
-			 * We have to check >= as it might be > in case of a high rate where another thread could already
-			 * have incremented it without decrementing it yet
+			 * The slot number is marked so that the received fragments can be counted and looked up
 			 */
-			fragmentCounter--;
+			receivedSubIDs[oldNumberOfFragments / 64].fetch_or(1ULL << (oldNumberOfFragments % 64),
+					std::memory_order_acq_rel);
+			return true;
+		}
+
+		const uint_fast16_t bit = subSourceIDLayout->getBit(fragment->getSourceSubID());
+		if (bit == SourceIDManager::INVALID_SUB_SOURCE_ID_BIT) {
 			return false;
 		}
 
+		const uint64_t mask = 1ULL << (bit % 64);
+		if (receivedSubIDs[bit / 64].fetch_or(mask, std::memory_order_acq_rel) & mask) {
+			return false; // duplicate
+		}
+
+		/*
+		 * Every expected sourceSubID can only pass once so the counter never exceeds expectedPacketsNum
+		 */
+		uint_fast16_t oldNumberOfFragments = fragmentCounter.fetch_add(1);
 		eventFragments[oldNumberOfFragments] = fragment;
 		return true;
 	}
@@ -74,14 +105,82 @@ public:
 	}
 
 	/**
-	 * Returns all missing source sub IDs. This only works correctly if the enabled sub IDs are consecutive numbers from 0 to ExpectedPacketsNum-1
+	 * Returns true if a fragment with the given sourceSubID has been received
+	 */
+	inline bool isSourceSubIdReceived(const uint_fast16_t sourceSubID) const {
+		if (!subSourceIDLayout->configured) {
+			for (uint_fast16_t word = 0; word != numberOfBitmapWords; word++) {
+				uint64_t received = receivedSubIDs[word].load(std::memory_order_acquire);
+				while (received != 0) {
+					const uint_fast16_t slot = word * 64 + __builtin_ctzll(received);
+					if (eventFragments[slot]->getSourceSubID() == sourceSubID) {
+						return true;
+					}
+					received &= received - 1;
+				}
+			}
+			return false;
+		}
+
+		const uint_fast16_t bit = subSourceIDLayout->getBit(sourceSubID);
+		if (bit == SourceIDManager::INVALID_SUB_SOURCE_ID_BIT) {
+			return false;
+		}
+		return receivedSubIDs[bit / 64].load(std::memory_order_acquire) & (1ULL << (bit % 64));
+	}
+
+	/**
+	 * Returns the number of expected sourceSubIDs that have not been received yet
+	 */
+	inline uint_fast16_t getNumberOfMissingSourceSubIds() const {
+		uint_fast16_t received = 0;
+		for (uint_fast16_t word = 0; word != numberOfBitmapWords; word++) {
+			received += __builtin_popcountll(receivedSubIDs[word].load(std::memory_order_acquire));
+		}
+		return expectedPacketsNum - received;
+	}
+
+	/**
+	 * Calls function(sourceSubID) for every expected sourceSubID that has not been received yet without allocating memory.
+	 * Nothing is reported if the sourceSubIDs of the source are not configured as they are unknown
+	 */
+	template<typename Function>
+	inline void forEachMissingSourceSubId(Function function) const {
+		if (expectedPacketsNum == 0 || !subSourceIDLayout->configured) {
+			return;
+		}
+		for (uint_fast16_t word = 0; word != numberOfBitmapWords; word++) {
+			uint64_t missing = ~receivedSubIDs[word].load(std::memory_order_acquire);
+			if (word == numberOfBitmapWords - 1 && expectedPacketsNum % 64 != 0) {
+				missing &= (1ULL << (expectedPacketsNum % 64)) - 1;
+			}
+			while (missing != 0) {
+				const uint_fast16_t bit = word * 64 + __builtin_ctzll(missing);
+				function(subSourceIDLayout->bitToSubID[bit]);
+				missing &= missing - 1;
+			}
+		}
+	}
+
+	/**
+	 * Returns all missing source sub IDs
 	 */
 	inline std::vector<uint> getMissingSourceSubIds() const {
-		// Not implemented
 		std::vector<uint> missingSubIDs;
+		missingSubIDs.reserve(getNumberOfMissingSourceSubIds());
+		forEachMissingSourceSubId([&missingSubIDs](uint_fast16_t sourceSubID) {
+			missingSubIDs.push_back(sourceSubID);
+		});
 		return missingSubIDs;
 	}
 
+	/**
+	 * Number of 64 bit words needed to mark the received sourceSubIDs of a Subevent with <expectedPacketsNum> fragments
+	 */
+	static inline uint_fast16_t getNumberOfBitmapWords(const uint_fast16_t expectedPacketsNum) {
+		return expectedPacketsNum == 0 ? 1 : (expectedPacketsNum + 63) / 64;
+	}
+
 	/**
 	 * Returns the number of received subevent fragments
 	 *
@@ -97,10 +196,31 @@ public:
 	uint8_t getSourceID() {
 		return sourceID;
 	}
+
+	/**
+	 * Moves this Subevent to the same sourceNum of another layout with the same number of expected fragments.
+	 * Only to be used by EventPool::switchSourceLayout while no fragments are added
+	 */
+	void setLayout(const SourceLayout& layout) {
+		sourceID = SourceIDManager::l1SourceNumToID(layout, sourceNum);
+		subSourceIDLayout = &layout.l1SubSourceIDLayouts[sourceNum];
+	}
 private:
 	const uint_fast16_t expectedPacketsNum;
-	const uint_fast8_t sourceID;
+	uint_fast8_t sourceID;
+	const uint_fast8_t sourceNum;
+	/*
+	 * sourceSubID <-> bit mapping of the layout of the owning Event
+	 */
+	const SourceIDManager::SubSourceIDLayout* subSourceIDLayout;
+	const uint_fast16_t numberOfBitmapWords;
+	const bool ownsEventFragments;
 	MEPFragment ** eventFragments;
+	/*
+	 * Bit n is set if the sourceSubID subSourceIDLayout->bitToSubID[n] has been received or, without configured
+	 * sourceSubIDs, if eventFragments[n] has been stored
+	 */
+	std::atomic<uint64_t>* receivedSubIDs;
 	std::atomic<uint_fast16_t> fragmentCounter;
 };
 
@@ -15,9 +15,11 @@
 
 #include "../options/Logging.h"
 #include "../eventBuilding/Event.h"
+#include "../eventBuilding/EventArena.h"
 #include "../eventBuilding/EventPool.h"
 #include "../eventBuilding/SourceIDManager.h"
 #include "../utils/DataDumper.h"
+#include "LatencyStatistics.h"
 #include "../l0/MEPFragment.h"
 #include "../l0/Subevent.h"
 #include "../structs/L0TPHeader.h"
@@ -31,6 +33,7 @@ uint BurstIdHandler::currentBurstID_;
 std::atomic<bool> BurstIdHandler::running_(false);
 std::atomic<bool> BurstIdHandler::flushBurst_(false);
 std::function<void()> BurstIdHandler::burstCleanupFunction_(nullptr);
+bool BurstIdHandler::sweepUnfinishedEvents_(false);
 
 void BurstIdHandler::thread(){
 	while(BurstIdHandler::running_) {
@@ -44,7 +47,14 @@ void BurstIdHandler::thread(){
 			// Flush all events
 			LOG_INFO("Cleanup of burst " << (int) BurstIdHandler::getCurrentBurstId());
 			//onBurstFinished();
+			if (BurstIdHandler::sweepUnfinishedEvents_) {
+				// Fragments of the next burst may already be arriving: its events are kept
+				EventPool::sweepUnfinishedEvents(BurstIdHandler::nextBurstId_);
+			}
 			BurstIdHandler::burstCleanupFunction_();
+			EventPool::switchSourceLayout();
+			LatencyStatistics::writeBurstSnapshot(BurstIdHandler::getCurrentBurstId());
+			EventArena::reportPageFaults(BurstIdHandler::getCurrentBurstId());
 			BurstIdHandler::currentBurstID_ = BurstIdHandler::nextBurstId_;
 			BurstIdHandler::flushBurst_ = false;
 
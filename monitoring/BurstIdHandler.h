@@ -52,12 +52,19 @@ public:
 		return flushBurst_ ;
 	}
 
-	static void initialize(uint startBurstID, std::function<void()> burstCleanupFunction) {
+	/**
+	 * <burstCleanupFunction> is called at every burst change. With <sweepUnfinishedEvents> the unfinished
+	 * events of the finished burst are freed in parallel via EventPool::sweepUnfinishedEvents before the
+	 * function is called, so that it only finds completed events left
+	 */
+	static void initialize(uint startBurstID, std::function<void()> burstCleanupFunction,
+			bool sweepUnfinishedEvents = false) {
 		currentBurstID_ = startBurstID;
 		nextBurstId_ = currentBurstID_;
 		running_ = true;
 		flushBurst_ = false;
 		burstCleanupFunction_ = burstCleanupFunction;
+		sweepUnfinishedEvents_ = sweepUnfinishedEvents;
 	}
 
 	static void shutDown() {
@@ -85,6 +92,7 @@ private:
 	static std::atomic<bool> running_;
 	static std::atomic<bool> flushBurst_;
 	static std::function<void()> burstCleanupFunction_;
+	static bool sweepUnfinishedEvents_;
 };
 
 }
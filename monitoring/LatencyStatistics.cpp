@@ -0,0 +1,95 @@
+/*
+ * LatencyStatistics.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "LatencyStatistics.h"
+
+#include <sstream>
+
+#include "../eventBuilding/Event.h"
+#include "../options/Logging.h"
+#include "../utils/DataDumper.h"
+
+namespace na62 {
+
+thread_local LatencyStatistics::ThreadHistograms* LatencyStatistics::threadHistograms_ = nullptr;
+std::vector<LatencyStatistics::ThreadHistograms*> LatencyStatistics::threads_;
+std::mutex LatencyStatistics::threadsMutex_;
+LatencyStatistics::ThreadHistograms LatencyStatistics::lastSnapshot_;
+std::string LatencyStatistics::outputDirectory_;
+
+LatencyStatistics::ThreadHistograms* LatencyStatistics::registerThread() {
+	/*
+	 * Never deleted: the counts of finished threads stay part of the statistics
+	 */
+	threadHistograms_ = new ThreadHistograms();
+	std::lock_guard<std::mutex> lock(threadsMutex_);
+	threads_.push_back(threadHistograms_);
+	return threadHistograms_;
+}
+
+std::string LatencyStatistics::getStageName(const LatencyStage stage) {
+	switch (stage) {
+	case LATENCY_L0_BUILDING:
+		return "L0Building";
+	case LATENCY_L1_PROCESSING:
+		return "L1Processing";
+	case LATENCY_L1_BUILDING:
+		return "L1Building";
+	case LATENCY_L2_PROCESSING:
+		return "L2Processing";
+	case LATENCY_EVENT_RESIDENCE:
+		return "EventResidence";
+	default:
+		return "UNKNOWN";
+	}
+}
+
+void LatencyStatistics::writeBurstSnapshot(const uint_fast32_t burstID) {
+#ifdef MEASURE_TIME
+	const double ticksPerMicrosecond = Event::getTicksPerMicrosecond();
+#else
+	const double ticksPerMicrosecond = 1;
+#endif
+
+	ThreadHistograms* total = new ThreadHistograms();
+	{
+		std::lock_guard<std::mutex> lock(threadsMutex_);
+		for (ThreadHistograms* thread : threads_) {
+			for (uint stage = 0; stage != NUMBER_OF_LATENCY_STAGES; stage++) {
+				thread->stages[stage].addTo(total->stages[stage]);
+			}
+		}
+	}
+
+	std::stringstream record;
+	record << "{\"burst\":" << burstID << ",\"unit\":\"us\"";
+	for (uint stage = 0; stage != NUMBER_OF_LATENCY_STAGES; stage++) {
+		/*
+		 * The thread histograms are never reset: the burst histogram is the difference to the last snapshot
+		 */
+		LogLinearHistogram burst;
+		total->stages[stage].addTo(burst);
+		burst.subtract(lastSnapshot_.stages[stage]);
+
+		lastSnapshot_.stages[stage].reset();
+		total->stages[stage].addTo(lastSnapshot_.stages[stage]);
+
+		record << ",\"" << getStageName((LatencyStage) stage) << "\":{\"n\":" << burst.getCount()
+				<< ",\"p50\":" << (uint64_t) (burst.getPercentile(50) / ticksPerMicrosecond)
+				<< ",\"p99\":" << (uint64_t) (burst.getPercentile(99) / ticksPerMicrosecond)
+				<< ",\"p99.9\":" << (uint64_t) (burst.getPercentile(99.9) / ticksPerMicrosecond)
+				<< ",\"max\":" << (uint64_t) (burst.getPercentile(100) / ticksPerMicrosecond) << "}";
+	}
+	record << "}";
+	delete total;
+
+	LOG_INFO("Latencies of burst " << burstID << ": " << record.str());
+	if (!outputDirectory_.empty()) {
+		DataDumper::printToFile("latency_statistics", outputDirectory_, record.str());
+	}
+}
+
+} /* namespace na62 */
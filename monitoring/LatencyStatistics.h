@@ -0,0 +1,86 @@
+/*
+ * LatencyStatistics.h
+ *
+ * Latency histograms of the event building and trigger stages. Every thread records into its own set of
+ * histograms so that recording is a plain increment without any shared cache line. At every burst change
+ * the histograms of all threads are merged and the difference to the previous snapshot is written as one
+ * line per burst (see writeBurstSnapshot).
+ *
+ * The values are recorded in ticks of the current Event::TimingMode and converted to microseconds when
+ * the snapshot is written.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#pragma once
+#ifndef LATENCYSTATISTICS_H_
+#define LATENCYSTATISTICS_H_
+
+#include <sys/types.h>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../utils/LogLinearHistogram.h"
+
+namespace na62 {
+
+enum LatencyStage {
+	LATENCY_L0_BUILDING, // First to last L0 fragment
+	LATENCY_L1_PROCESSING, // Last L0 fragment to L1 trigger decision
+	LATENCY_L1_BUILDING, // L1 trigger decision to last L1 fragment
+	LATENCY_L2_PROCESSING, // Last L1 fragment to L2 trigger decision
+	LATENCY_EVENT_RESIDENCE, // First fragment to destruction of the event
+	NUMBER_OF_LATENCY_STAGES
+};
+
+class LatencyStatistics {
+public:
+	static inline void record(const LatencyStage stage, const uint64_t ticks) {
+		ThreadHistograms* histograms = threadHistograms_;
+		if (histograms == nullptr) {
+			histograms = registerThread();
+		}
+		histograms->stages[stage].recordSingleWriter(ticks);
+	}
+
+	/**
+	 * Merges the histograms of all threads and writes p50, p99, p99.9 and the maximum of every stage recorded
+	 * since the last call. The record is logged and, if an output directory is set, appended to the file
+	 * latency_statistics in that directory. Called by the BurstIdHandler at every burst change
+	 */
+	static void writeBurstSnapshot(const uint_fast32_t burstID);
+
+	static void setOutputDirectory(const std::string outputDirectory) {
+		outputDirectory_ = outputDirectory;
+	}
+
+	static std::string getStageName(const LatencyStage stage);
+
+private:
+	struct ThreadHistograms {
+		LogLinearHistogram stages[NUMBER_OF_LATENCY_STAGES];
+	};
+
+	static ThreadHistograms* registerThread();
+
+	static thread_local ThreadHistograms* threadHistograms_;
+
+	/*
+	 * Histograms of all threads ever recorded. Protected by threadsMutex_
+	 */
+	static std::vector<ThreadHistograms*> threads_;
+	static std::mutex threadsMutex_;
+
+	/*
+	 * Sum of all thread histograms at the last snapshot
+	 */
+	static ThreadHistograms lastSnapshot_;
+
+	static std::string outputDirectory_;
+};
+
+} /* namespace na62 */
+
+#endif /* LATENCYSTATISTICS_H_ */
@@ -0,0 +1,75 @@
+/*
+ * MEPErrorStatistics.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "MEPErrorStatistics.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "../options/Logging.h"
+#include "../utils/Utils.h"
+
+namespace na62 {
+
+std::atomic<uint64_t> MEPErrorStatistics::l0ErrorsBySource_[256];
+std::atomic<uint64_t> MEPErrorStatistics::l1ErrorsBySource_[256];
+std::atomic<uint64_t> MEPErrorStatistics::errorsByType_[(uint) MEPParseError::NUMBER_OF_ERRORS];
+std::atomic<uint64_t> MEPErrorStatistics::suppressedHexDumps_(0);
+std::atomic<int64_t> MEPErrorStatistics::nextHexDumpTime_(0);
+uint MEPErrorStatistics::hexDumpIntervalMillis_ = 1000;
+
+/*
+ * Never dump more than this number of bytes of a single packet
+ */
+static const uint_fast16_t MaxHexDumpLength = 64;
+
+void MEPErrorStatistics::reportL0Error(const MEPParseStatus& status,
+		const char* data, const uint_fast16_t dataLength) {
+	l0ErrorsBySource_[status.sourceID].fetch_add(1, std::memory_order_relaxed);
+	report("L0", status, data, dataLength);
+}
+
+void MEPErrorStatistics::reportL1Error(const MEPParseStatus& status,
+		const char* data, const uint_fast16_t dataLength) {
+	l1ErrorsBySource_[status.sourceID].fetch_add(1, std::memory_order_relaxed);
+	report("L1", status, data, dataLength);
+}
+
+void MEPErrorStatistics::report(const char* level,
+		const MEPParseStatus& status, const char* data,
+		const uint_fast16_t dataLength) {
+	errorsByType_[(uint) status.error].fetch_add(1, std::memory_order_relaxed);
+
+	if (hexDumpIntervalMillis_ == 0) {
+		return;
+	}
+
+	const int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	int64_t nextHexDumpTime = nextHexDumpTime_.load(std::memory_order_relaxed);
+	if (now < nextHexDumpTime
+			|| !nextHexDumpTime_.compare_exchange_strong(nextHexDumpTime,
+					now + hexDumpIntervalMillis_, std::memory_order_relaxed)) {
+		suppressedHexDumps_.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	LOG_ERROR(level << " MEP dropped: " << status.toString() << " (" << suppressedHexDumps_.load() << " broken MEPs not dumped so far)\n"
+			<< Utils::PrintHex(data, std::min(dataLength, MaxHexDumpLength)));
+}
+
+void MEPErrorStatistics::reset() {
+	for (uint source = 0; source != 256; source++) {
+		l0ErrorsBySource_[source] = 0;
+		l1ErrorsBySource_[source] = 0;
+	}
+	for (auto& counter : errorsByType_) {
+		counter = 0;
+	}
+	suppressedHexDumps_ = 0;
+}
+
+} /* namespace na62 */
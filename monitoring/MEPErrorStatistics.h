@@ -0,0 +1,83 @@
+/*
+ * MEPErrorStatistics.h
+ *
+ * Counts corrupted MEPs per source ID and per error type. Hex dumps of the broken packets are
+ * only printed for a sample of the errors (at most one every <hexDumpIntervalMillis>) so that a
+ * misbehaving read out board can not slow down the receiver.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#pragma once
+#ifndef MEPERRORSTATISTICS_H_
+#define MEPERRORSTATISTICS_H_
+
+#include <sys/types.h>
+#include <atomic>
+#include <cstdint>
+
+#include "../exceptions/MEPParseStatus.h"
+
+namespace na62 {
+
+class MEPErrorStatistics {
+public:
+	/**
+	 * Registers a broken L0 MEP. <data> and <dataLength> define the packet to be dumped
+	 */
+	static void reportL0Error(const MEPParseStatus& status, const char* data,
+			const uint_fast16_t dataLength);
+
+	/**
+	 * Registers a broken L1 MEP. <data> and <dataLength> define the packet to be dumped
+	 */
+	static void reportL1Error(const MEPParseStatus& status, const char* data,
+			const uint_fast16_t dataLength);
+
+	/**
+	 * Sets the minimum time between two hex dumps. 0 disables the hex dumps
+	 */
+	static void setHexDumpInterval(const uint hexDumpIntervalMillis) {
+		hexDumpIntervalMillis_ = hexDumpIntervalMillis;
+	}
+
+	static inline uint64_t getL0ErrorsOfSource(const uint_fast8_t sourceID) {
+		return l0ErrorsBySource_[sourceID].load(std::memory_order_relaxed);
+	}
+
+	static inline uint64_t getL1ErrorsOfSource(const uint_fast8_t sourceID) {
+		return l1ErrorsBySource_[sourceID].load(std::memory_order_relaxed);
+	}
+
+	static inline uint64_t getErrorsOfType(const MEPParseError error) {
+		return errorsByType_[(uint) error].load(std::memory_order_relaxed);
+	}
+
+	/*
+	 * Number of errors not hex dumped due to the rate limit
+	 */
+	static inline uint64_t getSuppressedHexDumps() {
+		return suppressedHexDumps_.load(std::memory_order_relaxed);
+	}
+
+	static void reset();
+
+private:
+	static void report(const char* level, const MEPParseStatus& status,
+			const char* data, const uint_fast16_t dataLength);
+
+	static std::atomic<uint64_t> l0ErrorsBySource_[256];
+	static std::atomic<uint64_t> l1ErrorsBySource_[256];
+	static std::atomic<uint64_t> errorsByType_[(uint) MEPParseError::NUMBER_OF_ERRORS];
+	static std::atomic<uint64_t> suppressedHexDumps_;
+
+	/*
+	 * Earliest time (steady clock, milliseconds) at which the next hex dump may be printed
+	 */
+	static std::atomic<int64_t> nextHexDumpTime_;
+	static uint hexDumpIntervalMillis_;
+};
+
+} /* namespace na62 */
+
+#endif /* MEPERRORSTATISTICS_H_ */
@@ -7,7 +7,11 @@
 
 #include "EventSerializer.h"
 
+#include <sys/uio.h>
+#include <climits>
+#include <cerrno>
 #include <cstring>
+#include <vector>
 
 #include "../eventBuilding/Event.h"
 #include "../eventBuilding/SourceIDManager.h"
@@ -16,60 +20,85 @@
 #include "../l1/MEPFragment.h"
 #include "../l1/Subevent.h"
 #include "../structs/Event.h"
-#include "../structs/Versions.h"
+#include "SerializerContext.h"
 
 namespace na62 {
 
-uint EventSerializer::InitialEventBufferSize_;
-int EventSerializer::TotalNumberOfDetectors_;
-bool isUnfinishedEOB;
+/*
+ * Every block is followed by <offset % 4> zero bytes (32-bit alignment as expected by the merger)
+ */
+static inline uint getPaddedOffset(const uint eventOffset) {
+	return eventOffset + eventOffset % 4;
+}
+
+static inline uint writePadding(char* eventBuffer, const uint eventOffset) {
+	if (eventOffset % 4 != 0) {
+		memset(eventBuffer + eventOffset, 0, eventOffset % 4);
+	}
+	return getPaddedOffset(eventOffset);
+}
 
 void EventSerializer::initialize() {
 	/*
-	 * L0 + L1 sources
+	 * Nothing to prepare: every thread creates its SerializerContext on first use
 	 */
-	TotalNumberOfDetectors_ = SourceIDManager::NUMBER_OF_L0_DATA_SOURCES + SourceIDManager::NUMBER_OF_L1_DATA_SOURCES ;
-	InitialEventBufferSize_ = 1000;
-	isUnfinishedEOB = false;
 }
 
-char* EventSerializer::ResizeBuffer(char* buffer, const int oldLength,
-		const int newLength) {
-	char* newBuffer = new char[newLength];
-	memcpy(newBuffer, buffer, oldLength);
-	delete[] buffer;
-	return newBuffer;
+uint EventSerializer::getSerializedSize(const Event* event) {
+	const SourceLayout& layout = *event->getSourceLayout();
+	uint eventOffset = sizeof(EVENT_HDR) + 4 * (layout.numberOfL0Sources + layout.numberOfL1Sources);
+
+	SourceIDManager::forEachL0SourceNum(layout, [&](const uint_fast8_t sourceNum) {
+		const l0::Subevent* const subevent = event->getL0SubeventBySourceIDNum(sourceNum);
+		for (uint i = 0; i != subevent->getNumberOfFragments(); i++) {
+			eventOffset = getPaddedOffset(
+					eventOffset + subevent->getFragment(i)->getPayloadLength() + sizeof(L0_BLOCK_HDR));
+		}
+		for (uint i = subevent->getNumberOfFragments(); i < subevent->getNumberOfExpectedFragments(); i++) {
+			eventOffset = getPaddedOffset(eventOffset + sizeof(L0_BLOCK_HDR));
+		}
+	});
+
+	SourceIDManager::forEachL1SourceNum(layout, [&](const uint_fast8_t sourceNum) {
+		const l1::Subevent* const subevent = event->getL1SubeventBySourceIDNum(sourceNum);
+		for (uint i = 0; i != subevent->getNumberOfFragments(); i++) {
+			eventOffset = getPaddedOffset(eventOffset + subevent->getFragment(i)->getEventLength());
+		}
+		for (uint i = subevent->getNumberOfFragments(); i < subevent->getNumberOfExpectedFragments(); i++) {
+			eventOffset = getPaddedOffset(eventOffset + sizeof(l1::L1_EVENT_RAW_HDR));
+		}
+	});
+
+	return eventOffset + sizeof(EVENT_TRAILER);
 }
 
 EVENT_HDR* EventSerializer::SerializeEvent(const Event* event) {
-	uint eventBufferSize = InitialEventBufferSize_;
-	char* eventBuffer = new char[InitialEventBufferSize_];
+	char* eventBuffer = new char[getSerializedSize(event)];
+	SerializeEvent(event, eventBuffer);
+	return reinterpret_cast<EVENT_HDR*>(eventBuffer);
+}
 
-	isUnfinishedEOB = false;
-	EVENT_HDR* header = reinterpret_cast<EVENT_HDR*>(eventBuffer);
+uint EventSerializer::SerializeEvent(const Event* event, char* eventBuffer) {
+	SerializerContext& context = SerializerContext::get();
+	const std::vector<char>& skeleton = context.getSkeleton(*event->getSourceLayout());
+	memcpy(eventBuffer, skeleton.data(), skeleton.size());
 
+	EVENT_HDR* header = reinterpret_cast<EVENT_HDR*>(eventBuffer);
 	header->eventNum = event->getEventNumber();
-	header->formatVersion = EVENT_HDR_FORMAT_VERSION; // TODO: update current format
 	// header->length will be written later on
 	header->burstID = event->getBurstID();
 	header->timestamp = event->getTimestamp();
 	header->triggerWord = event->getTriggerTypeWord();
-	header->reserved1 = 0;
 	header->fineTime = event->getFinetime();
-	header->numberOfDetectors = TotalNumberOfDetectors_;
-	header->reserved2 = 0;
 	header->processingID = event->getProcessingID();
-	header->SOBtimestamp = 0; // Will be set by the merger
 
-	uint sizeOfPointerTable = 4 * TotalNumberOfDetectors_;
+	bool isUnfinishedEOB = false;
 	uint pointerTableOffset = sizeof(EVENT_HDR);
-	uint eventOffset = sizeof(EVENT_HDR) + sizeOfPointerTable;
+	uint eventOffset = skeleton.size();
 
-	writeL0Data(event, eventBuffer, eventOffset, eventBufferSize,
-			pointerTableOffset);
+	writeL0Data(event, eventBuffer, eventOffset, pointerTableOffset, isUnfinishedEOB);
 
-	writeL1Data(event, eventBuffer, eventOffset, eventBufferSize,
-			pointerTableOffset);
+	writeL1Data(event, eventBuffer, eventOffset, pointerTableOffset, isUnfinishedEOB);
 
 	/*
 	 * Trailer
@@ -78,186 +107,299 @@ EVENT_HDR* EventSerializer::SerializeEvent(const Event* event) {
 	trailer->eventNum = event->getEventNumber();
 	trailer->reserved = 0;
 
-	const int eventLength = eventOffset + 4/*trailer*/;
+	const uint eventLength = eventOffset + sizeof(EVENT_TRAILER);
+
+	if (isUnfinishedEOB) header->triggerWord = 0xfefe23;
 
-	if (eventBufferSize > InitialEventBufferSize_) {
-		InitialEventBufferSize_ = eventBufferSize;
+	header->length = eventLength / 4;
+	context.recordEventSize(eventLength);
+
+	return eventLength;
+}
+
+void EventIovec::release() {
+	if (event_ != nullptr) {
+		event_->unpin();
+		event_ = nullptr;
+	}
+}
+
+/*
+ * Appends generated bytes and fragment data to an EventIovec. Consecutive generated bytes share one iovec
+ */
+class IovecWriter {
+public:
+	IovecWriter(EventIovec& iovec) :
+			iovec_(iovec), generatedLength_(0) {
+	}
+
+	char* appendGenerated(const size_t length) {
+		char* data = &iovec_.generatedData[generatedLength_];
+		if (!iovec_.iovecs.empty()
+				&& static_cast<char*>(iovec_.iovecs.back().iov_base) + iovec_.iovecs.back().iov_len == data) {
+			iovec_.iovecs.back().iov_len += length;
+		} else {
+			iovec_.iovecs.push_back( { data, length });
+		}
+		generatedLength_ += length;
+		return data;
+	}
+
+	void appendData(const char* data, const size_t length) {
+		if (length != 0) {
+			iovec_.iovecs.push_back( { const_cast<char*>(data), length });
+		}
 	}
 
 	/*
-	 * header may have been overwritten -> redefine it
+	 * Same padding as writePadding
 	 */
-	header = reinterpret_cast<EVENT_HDR*>(eventBuffer);
+	uint appendPadding(const uint eventOffset) {
+		if (eventOffset % 4 != 0) {
+			memset(appendGenerated(eventOffset % 4), 0, eventOffset % 4);
+		}
+		return getPaddedOffset(eventOffset);
+	}
+
+private:
+	EventIovec& iovec_;
+	size_t generatedLength_;
+};
+
+uint EventSerializer::SerializeEvent(Event* event, EventIovec& iovec) {
+	iovec.release();
+	iovec.iovecs.clear();
+	if (!event->pin()) {
+		/*
+		 * The event has been freed before it could be pinned: its fragments are gone
+		 */
+		iovec.length = 0;
+		return 0;
+	}
+	iovec.event_ = event;
+
+	const SourceLayout& layout = *event->getSourceLayout();
+	SerializerContext& context = SerializerContext::get();
+	const std::vector<char>& skeleton = context.getSkeleton(layout);
+
+	/*
+	 * Every fragment or placeholder generates at most one L1_EVENT_RAW_HDR and 3 padding bytes. The
+	 * generated data must not be reallocated as the iovecs point into it
+	 */
+	const size_t numberOfBlocks = layout.expectedL0PacketsPerEvent + layout.expectedL1PacketsPerEvent;
+	iovec.generatedData.resize(
+			skeleton.size() + numberOfBlocks * (sizeof(l1::L1_EVENT_RAW_HDR) + 3) + sizeof(EVENT_TRAILER));
+	iovec.iovecs.reserve(2 * numberOfBlocks + 2);
+	IovecWriter writer(iovec);
+
+	char* headerAndPointerTable = writer.appendGenerated(skeleton.size());
+	memcpy(headerAndPointerTable, skeleton.data(), skeleton.size());
+
+	EVENT_HDR* header = reinterpret_cast<EVENT_HDR*>(headerAndPointerTable);
+	header->eventNum = event->getEventNumber();
+	// header->length will be written later on
+	header->burstID = event->getBurstID();
+	header->timestamp = event->getTimestamp();
+	header->triggerWord = event->getTriggerTypeWord();
+	header->fineTime = event->getFinetime();
+	header->processingID = event->getProcessingID();
+
+	bool isUnfinishedEOB = false;
+	char* pointerTable = headerAndPointerTable + sizeof(EVENT_HDR);
+	uint eventOffset = skeleton.size();
+
+	SourceIDManager::forEachL0SourceNum(layout, [&](const uint_fast8_t sourceNum) {
+		const l0::Subevent* const subevent = event->getL0SubeventBySourceIDNum(sourceNum);
+
+		uint eventOffset32 = eventOffset / 4;
+		std::memcpy(pointerTable, &eventOffset32, 3);
+		pointerTable += 4;
+
+		for (uint i = 0; i != subevent->getNumberOfFragments(); i++) {
+			const l0::MEPFragment* const fragment = subevent->getFragment(i);
+			const uint payloadLength = fragment->getPayloadLength() + sizeof(L0_BLOCK_HDR);
+
+			L0_BLOCK_HDR* blockHdr = reinterpret_cast<L0_BLOCK_HDR*>(writer.appendGenerated(
+					sizeof(L0_BLOCK_HDR)));
+			blockHdr->dataBlockSize = payloadLength;
+			blockHdr->sourceSubID = fragment->getSourceSubID();
+			blockHdr->reserved = 0x01;
+			blockHdr->timestamp = fragment->getTimestamp();
+
+			writer.appendData(fragment->getPayload(), fragment->getPayloadLength());
+			eventOffset = writer.appendPadding(eventOffset + payloadLength);
+		}
+		for (uint i = subevent->getNumberOfFragments(); i < subevent->getNumberOfExpectedFragments(); i++) {
+			isUnfinishedEOB = true;
+			L0_BLOCK_HDR* blockHdr = reinterpret_cast<L0_BLOCK_HDR*>(writer.appendGenerated(
+					sizeof(L0_BLOCK_HDR)));
+			blockHdr->dataBlockSize = sizeof(L0_BLOCK_HDR);
+			blockHdr->reserved = 0x01;
+			blockHdr->sourceSubID = 0x00;
+			blockHdr->timestamp = 0xffffffff;
+			eventOffset = writer.appendPadding(eventOffset + sizeof(L0_BLOCK_HDR));
+		}
+	});
+
+	SourceIDManager::forEachL1SourceNum(layout, [&](const uint_fast8_t sourceNum) {
+		const l1::Subevent* const subevent = event->getL1SubeventBySourceIDNum(sourceNum);
+
+		uint eventOffset32 = eventOffset / 4;
+		std::memcpy(pointerTable, &eventOffset32, 3);
+		pointerTable += 4;
+
+		for (uint fragmentNum = 0; fragmentNum != subevent->getNumberOfFragments(); fragmentNum++) {
+			const l1::MEPFragment* const e = subevent->getFragment(fragmentNum);
+			writer.appendData(e->getDataWithHeader(), e->getEventLength());
+			eventOffset = writer.appendPadding(eventOffset + e->getEventLength());
+		}
+		for (uint i = subevent->getNumberOfFragments(); i < subevent->getNumberOfExpectedFragments(); i++) {
+			isUnfinishedEOB = true;
+			l1::L1_EVENT_RAW_HDR* blockHdr = reinterpret_cast<l1::L1_EVENT_RAW_HDR*>(writer.appendGenerated(
+					sizeof(l1::L1_EVENT_RAW_HDR)));
+			blockHdr->eventNumber = event->getEventNumber();
+			blockHdr->sourceID = SourceIDManager::l1SourceNumToID(layout, sourceNum);
+			blockHdr->numberOf4BWords = sizeof(l1::L1_EVENT_RAW_HDR) / 4;
+			blockHdr->reserved = 0;
+			blockHdr->timestamp = 0xffffffff;
+			blockHdr->sourceSubID = 0;
+			blockHdr->l0TriggerWord = event->getL0TriggerTypeWord();
+			blockHdr->reserved2 = 0;
+			eventOffset = writer.appendPadding(eventOffset + sizeof(l1::L1_EVENT_RAW_HDR));
+		}
+	});
+
+	/*
+	 * Trailer
+	 */
+	EVENT_TRAILER* trailer = reinterpret_cast<EVENT_TRAILER*>(writer.appendGenerated(sizeof(EVENT_TRAILER)));
+	trailer->eventNum = event->getEventNumber();
+	trailer->reserved = 0;
+
+	iovec.length = eventOffset + sizeof(EVENT_TRAILER);
+
 	if (isUnfinishedEOB) header->triggerWord = 0xfefe23;
 
-	header->length = eventLength / 4;
+	header->length = iovec.length / 4;
+	context.recordEventSize(iovec.length);
 
-	return header;
+	return iovec.length;
 }
 
-char* EventSerializer::writeL0Data(const Event* event, char*& eventBuffer, uint& eventOffset,
-uint& eventBufferSize, uint& pointerTableOffset) {
+bool EventSerializer::writeIovec(const int fd, EventIovec& iovec) {
+	struct iovec* iov = iovec.iovecs.data();
+	size_t remaining = iovec.iovecs.size();
+	while (remaining != 0) {
+		const ssize_t written = writev(fd, iov, std::min<size_t>(remaining, IOV_MAX));
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+
+		/*
+		 * Skip all completely written iovecs and continue the partially written one
+		 */
+		size_t bytes = written;
+		while (remaining != 0 && bytes >= iov->iov_len) {
+			bytes -= iov->iov_len;
+			iov++;
+			remaining--;
+		}
+		if (remaining != 0) {
+			iov->iov_base = static_cast<char*>(iov->iov_base) + bytes;
+			iov->iov_len -= bytes;
+		}
+	}
+	return true;
+}
+
+void EventSerializer::writeL0Data(const Event* event, char* eventBuffer, uint& eventOffset,
+		uint& pointerTableOffset, bool& isUnfinishedEOB) {
 	/*
 	 * Write all L0 data sources
 	 */
-	for (int sourceNum = 0; sourceNum != SourceIDManager::NUMBER_OF_L0_DATA_SOURCES; sourceNum++) {
+	SourceIDManager::forEachL0SourceNum(*event->getSourceLayout(), [&](const uint_fast8_t sourceNum) {
 		const l0::Subevent* const subevent = event->getL0SubeventBySourceIDNum(sourceNum);
 
-		if (eventOffset + 4 > eventBufferSize) {
-			eventBuffer = ResizeBuffer(eventBuffer, eventBufferSize,
-					eventBufferSize + 1000);
-			eventBufferSize += 1000;
-		}
-
 		/*
-		 * Put the sub-detector into the pointer table
+		 * Put the sub-detector into the pointer table. The sourceID is part of the skeleton
 		 */
 		uint eventOffset32 = eventOffset / 4;
 		std::memcpy(eventBuffer + pointerTableOffset, &eventOffset32, 3);
-		std::memset(eventBuffer + pointerTableOffset + 3,
-				SourceIDManager::sourceNumToID(sourceNum), 1);
 		pointerTableOffset += 4;
 
 		/*
 		 * Write all fragments
 		 */
-		int payloadLength;
 		for (uint i = 0; i != subevent->getNumberOfFragments(); i++) {
 			const l0::MEPFragment* const fragment = subevent->getFragment(i);
-			payloadLength = fragment->getPayloadLength() + sizeof(L0_BLOCK_HDR);
-			if (eventOffset + payloadLength > eventBufferSize) {
-				eventBuffer = ResizeBuffer(eventBuffer, eventBufferSize,
-						eventBufferSize + payloadLength);
-				eventBufferSize += payloadLength;
-			}
+			const uint payloadLength = fragment->getPayloadLength() + sizeof(L0_BLOCK_HDR);
 
 			L0_BLOCK_HDR* blockHdr = reinterpret_cast<L0_BLOCK_HDR*>(eventBuffer
 					+ eventOffset);
 			blockHdr->dataBlockSize = payloadLength;
 			blockHdr->sourceSubID = fragment->getSourceSubID();
 			blockHdr->reserved = 0x01;
-			blockHdr->timestamp = fragment->getTimestamp();			
+			blockHdr->timestamp = fragment->getTimestamp();
 
 			memcpy(eventBuffer + eventOffset + sizeof(L0_BLOCK_HDR),
 					fragment->getPayload(),
 					payloadLength - sizeof(L0_BLOCK_HDR));
-			eventOffset += payloadLength;
-
-			/*
-			 * 32-bit alignment
-			 */
-			if (eventOffset % 4 != 0) {
-				memset(eventBuffer + eventOffset, 0, eventOffset % 4);
-				eventOffset += eventOffset % 4;
-			}
+			eventOffset = writePadding(eventBuffer, eventOffset + payloadLength);
 		}
 		// Add here missing fragments: could actually be handled dynamically by decoders
-		if (subevent->getNumberOfFragments() < subevent->getNumberOfExpectedFragments() ) {
-			uint missingFrags = subevent->getNumberOfExpectedFragments() - subevent->getNumberOfFragments();
-			for (uint i = 0; i != missingFrags; i++) {
-				payloadLength = sizeof(L0_BLOCK_HDR);
-                if (eventOffset + payloadLength > eventBufferSize) {
-                         eventBuffer = ResizeBuffer(eventBuffer, eventBufferSize,
-                                         eventBufferSize + payloadLength);
-                         eventBufferSize += payloadLength;
-                 }
-	 	 isUnfinishedEOB = true;
-                 L0_BLOCK_HDR* blockHdr = reinterpret_cast<L0_BLOCK_HDR*>(eventBuffer
-                                 + eventOffset);
-                 blockHdr->dataBlockSize = payloadLength;
-                 blockHdr->reserved = 0x01;
-                 blockHdr->sourceSubID = 0x00;
-                 blockHdr->timestamp = 0xffffffff;
-                 eventOffset += payloadLength;
-                 /*
-                  * 32-bit alignment
-                  */
-                 if (eventOffset % 4 != 0) {
-                         memset(eventBuffer + eventOffset, 0, eventOffset % 4);
-                         eventOffset += eventOffset % 4;
-                 }
-			}
+		for (uint i = subevent->getNumberOfFragments(); i < subevent->getNumberOfExpectedFragments(); i++) {
+			isUnfinishedEOB = true;
+			L0_BLOCK_HDR* blockHdr = reinterpret_cast<L0_BLOCK_HDR*>(eventBuffer
+					+ eventOffset);
+			blockHdr->dataBlockSize = sizeof(L0_BLOCK_HDR);
+			blockHdr->reserved = 0x01;
+			blockHdr->sourceSubID = 0x00;
+			blockHdr->timestamp = 0xffffffff;
+			eventOffset = writePadding(eventBuffer, eventOffset + sizeof(L0_BLOCK_HDR));
 		}
-	}
-
-	return eventBuffer;
+	});
 }
 
-char* EventSerializer::writeL1Data(const Event* event, char*& eventBuffer, uint& eventOffset,
-		uint& eventBufferSize, uint& pointerTableOffset) {
+void EventSerializer::writeL1Data(const Event* event, char* eventBuffer, uint& eventOffset,
+		uint& pointerTableOffset, bool& isUnfinishedEOB) {
 
-	for (int sourceNum = 0; sourceNum != SourceIDManager::NUMBER_OF_L1_DATA_SOURCES; sourceNum++) {
+	SourceIDManager::forEachL1SourceNum(*event->getSourceLayout(), [&](const uint_fast8_t sourceNum) {
 		const l1::Subevent* const subevent = event->getL1SubeventBySourceIDNum(sourceNum);
 
-		if (eventOffset + 4 > eventBufferSize) {
-			eventBuffer = ResizeBuffer(eventBuffer, eventBufferSize,
-					eventBufferSize + 1000);
-			eventBufferSize += 1000;
-		}
-
 		uint eventOffset32 = eventOffset / 4;
 		/*
 		 * Put the LKr into the pointer table
 		 */
 		std::memcpy(eventBuffer + pointerTableOffset, &eventOffset32, 3);
-		std::memset(eventBuffer + pointerTableOffset + 3, SourceIDManager::l1SourceNumToID(sourceNum), 1);
 		pointerTableOffset += 4;
 
 		for (uint fragmentNum = 0; fragmentNum != subevent->getNumberOfFragments(); fragmentNum++) {
 			l1::MEPFragment* e = subevent->getFragment(fragmentNum);
 
-			if (eventOffset + e->getEventLength() > eventBufferSize) {
-				eventBuffer = ResizeBuffer(eventBuffer, eventBufferSize,
-						eventBufferSize + e->getEventLength());
-				eventBufferSize += e->getEventLength();
-			}
-
 			memcpy(eventBuffer + eventOffset, e->getDataWithHeader(),
 					e->getEventLength());
-			eventOffset += e->getEventLength();
-
-			/*
-			 * 32-bit alignment
-			 */
-			if (eventOffset % 4 != 0) {
-				memset(eventBuffer + eventOffset, 0, eventOffset % 4);
-				eventOffset += eventOffset % 4;
-			}
+			eventOffset = writePadding(eventBuffer, eventOffset + e->getEventLength());
 		}
 
 		// Add here missing fragments: could actually be handled dynamically by decoders
-		if (subevent->getNumberOfFragments() < subevent->getNumberOfExpectedFragments() ) {
-			uint missingFrags = subevent->getNumberOfExpectedFragments() - subevent->getNumberOfFragments();
-			for (uint i = 0; i != missingFrags; i++) {
-				int payloadLength = sizeof(l1::L1_EVENT_RAW_HDR);
-                if (eventOffset + payloadLength > eventBufferSize) {
-                         eventBuffer = ResizeBuffer(eventBuffer, eventBufferSize,
-                                         eventBufferSize + payloadLength);
-                         eventBufferSize += payloadLength;
-                 }
-
-		isUnfinishedEOB=true;
-                 l1::L1_EVENT_RAW_HDR* blockHdr = reinterpret_cast<l1::L1_EVENT_RAW_HDR*>(eventBuffer + eventOffset);
-
-                 blockHdr->eventNumber = event->getEventNumber();
-                 blockHdr->sourceID = SourceIDManager::l1SourceNumToID(sourceNum);
-                 blockHdr->numberOf4BWords = payloadLength/4;
-                 blockHdr->timestamp = 0xffffffff;
-                 blockHdr->sourceSubID = 0;
-                 blockHdr->l0TriggerWord = event->getL0TriggerTypeWord();
-                 memcpy(eventBuffer + eventOffset, blockHdr, sizeof(l1::L1_EVENT_RAW_HDR));
-                 eventOffset += payloadLength;
-                 /*
-                  * 32-bit alignment
-                  */
-                 if (eventOffset % 4 != 0) {
-                         memset(eventBuffer + eventOffset, 0, eventOffset % 4);
-                         eventOffset += eventOffset % 4;
-                 }
-			}
+		for (uint i = subevent->getNumberOfFragments(); i < subevent->getNumberOfExpectedFragments(); i++) {
+			isUnfinishedEOB = true;
+			l1::L1_EVENT_RAW_HDR* blockHdr = reinterpret_cast<l1::L1_EVENT_RAW_HDR*>(eventBuffer + eventOffset);
+
+			blockHdr->eventNumber = event->getEventNumber();
+			blockHdr->sourceID = SourceIDManager::l1SourceNumToID(*event->getSourceLayout(), sourceNum);
+			blockHdr->numberOf4BWords = sizeof(l1::L1_EVENT_RAW_HDR) / 4;
+			blockHdr->reserved = 0;
+			blockHdr->timestamp = 0xffffffff;
+			blockHdr->sourceSubID = 0;
+			blockHdr->l0TriggerWord = event->getL0TriggerTypeWord();
+			blockHdr->reserved2 = 0;
+			eventOffset = writePadding(eventBuffer, eventOffset + sizeof(l1::L1_EVENT_RAW_HDR));
 		}
-	}
-	return eventBuffer;
+	});
 }
 
 } /* namespace na62 */
@@ -9,36 +9,96 @@
 #define EVENTBUILDING_EVENTSERIALIZER_H_
 
 #include <sys/types.h>
+#include <sys/uio.h>
+#include <vector>
+#include <boost/noncopyable.hpp>
 
 namespace na62 {
 
 class Event;
 struct EVENT_HDR;
 
+/*
+ * Scatter-gather representation of a serialized event (see EventSerializer::SerializeEvent(Event*, EventIovec&)).
+ * The iovecs point either into generatedData (EVENT_HDR, pointer table, L0 block headers, placeholders of
+ * missing fragments, padding and trailer) or directly to the fragment data in the MEPs of the event. The
+ * event stays pinned until release() is called or the EventIovec is destroyed.
+ */
+struct EventIovec: private boost::noncopyable {
+	std::vector<struct iovec> iovecs;
+	std::vector<char> generatedData;
+	uint length; // Sum of all iovec lengths
+
+	EventIovec() :
+			length(0), event_(nullptr) {
+	}
+
+	~EventIovec() {
+		release();
+	}
+
+	/*
+	 * Unpins the event: it may be destroyed right away if it has been freed in the meantime. Call this as
+	 * soon as the I/O has completed
+	 */
+	void release();
+
+private:
+	friend class EventSerializer;
+	Event* event_;
+};
+
 namespace cream {
 class LkrFragment;
 } /* namespace cream */
 
+/*
+ * All methods may be called by any number of threads concurrently: the mutable state lives in the
+ * SerializerContext of the calling thread
+ */
 class EventSerializer {
 public:
 	/**
 	 * Generates the raw data as it should be send to the merger
-	 * The returned buffer must be deleted by you!
+	 * The returned buffer has exactly the size of the event (header->length * 4 bytes) and must be deleted by
+	 * you (delete[])! SerializerContext::get().serialize(event) reuses the buffers instead
 	 */
 	static EVENT_HDR* SerializeEvent(const Event* event);
 
+	/**
+	 * Same as SerializeEvent(event) but writes to <buffer> which must provide at least
+	 * getSerializedSize(event) bytes. Returns the number of bytes written
+	 */
+	static uint SerializeEvent(const Event* event, char* buffer);
+
+	/**
+	 * Scatter-gather version of SerializeEvent: the fragment data is not copied but referenced by the
+	 * iovecs which can be passed to writev or sendmsg (see writeIovec). The event is pinned (see Event::pin)
+	 * until <iovec> is released, so it may be given back to the EventPool right after this call.
+	 * Returns the number of bytes described by the iovecs, or 0 with empty iovecs if the event could not
+	 * be pinned because it has already been freed
+	 */
+	static uint SerializeEvent(Event* event, EventIovec& iovec);
+
+	/**
+	 * Writes the whole event described by <iovec> to <fd> using writev with at most IOV_MAX iovecs per
+	 * call. Partially written iovecs are continued, so the iovecs are modified. Returns false if writev
+	 * failed (see errno)
+	 */
+	static bool writeIovec(const int fd, EventIovec& iovec);
+
+	/**
+	 * Exact number of bytes SerializeEvent will write for the given event
+	 */
+	static uint getSerializedSize(const Event* event);
+
 	static void initialize();
 
 private:
-	static uint InitialEventBufferSize_;
-	static int TotalNumberOfDetectors_;
-	static char* writeL0Data(const Event* event, char*& eventBuffer, uint& eventOffset,
-	uint& eventBufferSize, uint& pointerTableOffset);
-	static char* writeL1Data(const Event* event, char*& eventBuffer, uint& eventOffset,
-			uint& eventBufferSize, uint& pointerTableOffset);
-
-	static char* ResizeBuffer(char* buffer, const int oldLength,
-			const int newLength);
+	static void writeL0Data(const Event* event, char* eventBuffer, uint& eventOffset,
+			uint& pointerTableOffset, bool& isUnfinishedEOB);
+	static void writeL1Data(const Event* event, char* eventBuffer, uint& eventOffset,
+			uint& pointerTableOffset, bool& isUnfinishedEOB);
 };
 
 } /* namespace na62 */
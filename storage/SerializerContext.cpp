@@ -0,0 +1,123 @@
+/*
+ * SerializerContext.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "SerializerContext.h"
+
+#include "../eventBuilding/Event.h"
+#include "../eventBuilding/SourceIDManager.h"
+#include "../structs/Event.h"
+#include "../structs/Versions.h"
+#include "EventSerializer.h"
+
+namespace na62 {
+
+std::mutex SerializerContext::contextsMutex_;
+std::vector<SerializerContext*> SerializerContext::contexts_;
+
+static thread_local SerializerContext* threadContext = nullptr;
+
+SerializerContext::SerializerContext() :
+		freeBuffers_(BuffersPerContext), isSkeletonBuilt_(false), skeletonLayoutVersion_(0), bufferHits_(0), bufferMisses_(
+				0) {
+}
+
+SerializerContext& SerializerContext::get() {
+	if (threadContext == nullptr) {
+		threadContext = new SerializerContext();
+		std::lock_guard<std::mutex> lock(contextsMutex_);
+		contexts_.push_back(threadContext);
+	}
+	return *threadContext;
+}
+
+char* SerializerContext::getBuffer(const uint size) {
+	char* buffer;
+	if (freeBuffers_.pop(buffer)) {
+		if (reinterpret_cast<BufferHeader*>(buffer)->capacity >= size) {
+			bufferHits_.store(bufferHits_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			return buffer;
+		}
+		delete[] buffer;
+	}
+	bufferMisses_.store(bufferMisses_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+	// Round up to whole pages so that slightly larger events can reuse the buffer
+	const uint capacity = (size + 4095) & ~4095;
+	buffer = new char[sizeof(BufferHeader) + capacity];
+	BufferHeader* header = reinterpret_cast<BufferHeader*>(buffer);
+	header->owner = this;
+	header->capacity = capacity;
+	return buffer;
+}
+
+EVENT_HDR* SerializerContext::serialize(const Event* event) {
+	char* buffer = getBuffer(EventSerializer::getSerializedSize(event));
+	EventSerializer::SerializeEvent(event, buffer + sizeof(BufferHeader));
+	return reinterpret_cast<EVENT_HDR*>(buffer + sizeof(BufferHeader));
+}
+
+void SerializerContext::returnBuffer(EVENT_HDR* event) {
+	char* buffer = reinterpret_cast<char*>(event) - sizeof(BufferHeader);
+	if (!reinterpret_cast<BufferHeader*>(buffer)->owner->freeBuffers_.push(buffer)) {
+		delete[] buffer;
+	}
+}
+
+const std::vector<char>& SerializerContext::getSkeleton(const SourceLayout& layout) {
+	if (isSkeletonBuilt_ && skeletonLayoutVersion_ == layout.version) {
+		return skeleton_;
+	}
+
+	const uint numberOfDetectors = layout.numberOfL0Sources + layout.numberOfL1Sources;
+	skeleton_.assign(sizeof(EVENT_HDR) + 4 * numberOfDetectors, 0);
+
+	EVENT_HDR* header = reinterpret_cast<EVENT_HDR*>(skeleton_.data());
+	header->formatVersion = EVENT_HDR_FORMAT_VERSION; // TODO: update current format
+	header->reserved1 = 0;
+	header->numberOfDetectors = numberOfDetectors;
+	header->reserved2 = 0;
+	header->SOBtimestamp = 0; // Will be set by the merger
+
+	char* pointerTable = skeleton_.data() + sizeof(EVENT_HDR);
+	SourceIDManager::forEachL0SourceNum(layout, [&](const uint_fast8_t sourceNum) {
+		pointerTable[4 * sourceNum + 3] = SourceIDManager::sourceNumToID(layout, sourceNum);
+	});
+	pointerTable += 4 * layout.numberOfL0Sources;
+	SourceIDManager::forEachL1SourceNum(layout, [&](const uint_fast8_t sourceNum) {
+		pointerTable[4 * sourceNum + 3] = SourceIDManager::l1SourceNumToID(layout, sourceNum);
+	});
+
+	skeletonLayoutVersion_ = layout.version;
+	isSkeletonBuilt_ = true;
+	return skeleton_;
+}
+
+void SerializerContext::collectSizeHistograms(LogLinearHistogram& sum) {
+	std::lock_guard<std::mutex> lock(contextsMutex_);
+	for (SerializerContext* context : contexts_) {
+		context->sizeHistogram_.addTo(sum);
+	}
+}
+
+uint64_t SerializerContext::getTotalBufferHits() {
+	std::lock_guard<std::mutex> lock(contextsMutex_);
+	uint64_t sum = 0;
+	for (SerializerContext* context : contexts_) {
+		sum += context->getBufferHits();
+	}
+	return sum;
+}
+
+uint64_t SerializerContext::getTotalBufferMisses() {
+	std::lock_guard<std::mutex> lock(contextsMutex_);
+	uint64_t sum = 0;
+	for (SerializerContext* context : contexts_) {
+		sum += context->getBufferMisses();
+	}
+	return sum;
+}
+
+} /* namespace na62 */
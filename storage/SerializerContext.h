@@ -0,0 +1,127 @@
+/*
+ * SerializerContext.h
+ *
+ * State of the EventSerializer owned by one thread: the serialization skeleton of the current source
+ * layout, a pool of reusable output buffers and statistics of the serialized event sizes. Nothing is
+ * shared between the serializing threads apart from the registry of all contexts used for monitoring.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#pragma once
+#ifndef SERIALIZERCONTEXT_H_
+#define SERIALIZERCONTEXT_H_
+
+#include <sys/types.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+#include "../utils/BoundedMPMCQueue.h"
+#include "../utils/LogLinearHistogram.h"
+
+namespace na62 {
+
+class Event;
+class SourceLayout;
+struct EVENT_HDR;
+
+class SerializerContext: private boost::noncopyable {
+public:
+	/*
+	 * Maximum number of free output buffers kept by every context
+	 */
+	static const uint_fast32_t BuffersPerContext = 64;
+
+	/*
+	 * Returns the context of the calling thread which is created on first use. Contexts are never destroyed
+	 * so that buffers may still be returned after their thread has exited
+	 */
+	static SerializerContext& get();
+
+	/*
+	 * Serializes the event into an output buffer of this context. The buffer must be given back via
+	 * returnBuffer (from any thread) instead of being deleted
+	 */
+	EVENT_HDR* serialize(const Event* event);
+
+	/*
+	 * Gives a buffer returned by serialize() back to the context it was taken from. May be called by
+	 * any thread
+	 */
+	static void returnBuffer(EVENT_HDR* event);
+
+	/*
+	 * EVENT_HDR and pointer table with all fields depending only on the source layout. Rebuilt if the
+	 * layout has changed since the last call
+	 */
+	const std::vector<char>& getSkeleton(const SourceLayout& layout);
+
+	/*
+	 * Must only be called by the owning thread
+	 */
+	inline void recordEventSize(const uint size) {
+		sizeHistogram_.recordSingleWriter(size);
+	}
+
+	const LogLinearHistogram& getSizeHistogram() const {
+		return sizeHistogram_;
+	}
+
+	uint64_t getBufferHits() const {
+		return bufferHits_.load(std::memory_order_relaxed);
+	}
+
+	uint64_t getBufferMisses() const {
+		return bufferMisses_.load(std::memory_order_relaxed);
+	}
+
+	/*
+	 * Adds the size histograms of all contexts to <sum>
+	 */
+	static void collectSizeHistograms(LogLinearHistogram& sum);
+
+	static uint64_t getTotalBufferHits();
+	static uint64_t getTotalBufferMisses();
+
+	static uint getNumberOfContexts() {
+		std::lock_guard<std::mutex> lock(contextsMutex_);
+		return contexts_.size();
+	}
+
+private:
+	/*
+	 * Stored in front of every output buffer. 16 bytes to keep the EVENT_HDR aligned like any new[] allocation
+	 */
+	struct alignas(16) BufferHeader {
+		SerializerContext* owner;
+		uint capacity;
+	};
+
+	SerializerContext();
+
+	/*
+	 * Returns a buffer with at least <size> bytes behind its BufferHeader
+	 */
+	char* getBuffer(const uint size);
+
+	BoundedMPMCQueue<char*> freeBuffers_;
+
+	bool isSkeletonBuilt_;
+	uint32_t skeletonLayoutVersion_;
+	std::vector<char> skeleton_;
+
+	LogLinearHistogram sizeHistogram_;
+	// Only written by the owning thread
+	std::atomic<uint64_t> bufferHits_;
+	std::atomic<uint64_t> bufferMisses_;
+
+	static std::mutex contextsMutex_;
+	static std::vector<SerializerContext*> contexts_;
+};
+
+} /* namespace na62 */
+
+#endif /* SERIALIZERCONTEXT_H_ */
@@ -7,23 +7,134 @@
 
 #include "DataContainer.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DATACONTAINER_HAVE_X86_KERNELS
+#endif
+
 namespace na62 {
 
+DataContainer::ChecksumPolicy DataContainer::checksumPolicy_ =
+		DataContainer::CHECKSUM_ALWAYS;
+uint DataContainer::checksumSampleRate_ = 1;
+
+static thread_local uint containersSinceLastChecksum = 0;
+
 DataContainer::DataContainer(char* _data, uint_fast16_t _length,
 		bool _ownerMayFreeData) :
-		data(_data), length(_length), ownerMayFreeData(_ownerMayFreeData) {
+		data(_data), length(_length), ownerMayFreeData(_ownerMayFreeData), checksum(
+				0), hasChecksum(false) {
+	switch (checksumPolicy_) {
+	case CHECKSUM_OFF:
+		return;
+	case CHECKSUM_SAMPLED:
+		if (++containersSinceLastChecksum < checksumSampleRate_) {
+			return;
+		}
+		containersSinceLastChecksum = 0;
+		break;
+	case CHECKSUM_ALWAYS:
+		break;
+	}
 	checksum = GenerateChecksum(_data, _length, 0);
+	hasChecksum = true;
 }
 
 bool DataContainer::checkValid() {
-	if(checksum==0 && data == nullptr){
+	if (!hasChecksum || (checksum == 0 && data == nullptr)) {
 		return true;
 	}
 
 	if (checksum != GenerateChecksum(data, length, 0)) {
 		LOG_ERROR("Packet broke!");
+		return false;
+	}
+	return true;
+}
+
+#ifdef DATACONTAINER_HAVE_X86_KERNELS
+/*
+ * The vector kernels sum up the 32 bit words in native (little endian) byte order into 64 bit lanes
+ * instead of calling ntohl for every word. As the one's complement sum is byte order independent
+ * (RFC 1071) the folded 16 bit result only has to be byte swapped once. The remaining bytes are
+ * handled by GenerateChecksumUnwrapped which also takes care of the final fold.
+ */
+static inline uint64_t foldNativeSum(uint64_t sum) {
+	while (sum > 0xffffffffULL) {
+		sum = (sum & 0xffffffffULL) + (sum >> 32);
+	}
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+	return ((sum & 0xff) << 8) | (sum >> 8);
+}
+
+__attribute__((target("avx2")))
+static uint16_t generateChecksumUnwrappedAVX2(const char* data, int len,
+		uint64_t sum) {
+	const int blocks = len / sizeof(__m256i);
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i lanes = _mm256_setzero_si256();
+	for (int block = 0; block != blocks; block++) {
+		const __m256i words = _mm256_loadu_si256(
+				reinterpret_cast<const __m256i*>(data) + block);
+		lanes = _mm256_add_epi64(lanes, _mm256_unpacklo_epi32(words, zero));
+		lanes = _mm256_add_epi64(lanes, _mm256_unpackhi_epi32(words, zero));
+	}
+	uint64_t lane[4];
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(lane), lanes);
+	const uint64_t nativeSum = lane[0] + lane[1] + lane[2] + lane[3];
+
+	const int bytesDone = blocks * sizeof(__m256i);
+	return DataContainer::GenerateChecksumUnwrapped(data + bytesDone,
+			len - bytesDone, sum + foldNativeSum(nativeSum));
+}
+
+__attribute__((target("sse2")))
+static uint16_t generateChecksumUnwrappedSSE2(const char* data, int len,
+		uint64_t sum) {
+	const int blocks = len / sizeof(__m128i);
+	const __m128i zero = _mm_setzero_si128();
+	__m128i lanes = _mm_setzero_si128();
+	for (int block = 0; block != blocks; block++) {
+		const __m128i words = _mm_loadu_si128(
+				reinterpret_cast<const __m128i*>(data) + block);
+		lanes = _mm_add_epi64(lanes, _mm_unpacklo_epi32(words, zero));
+		lanes = _mm_add_epi64(lanes, _mm_unpackhi_epi32(words, zero));
 	}
-	return checksum != GenerateChecksum(data, length, 0);
+	uint64_t lane[2];
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(lane), lanes);
+	const uint64_t nativeSum = lane[0] + lane[1];
+
+	const int bytesDone = blocks * sizeof(__m128i);
+	return DataContainer::GenerateChecksumUnwrapped(data + bytesDone,
+			len - bytesDone, sum + foldNativeSum(nativeSum));
+}
+#endif
+
+typedef uint16_t (*ChecksumKernel)(const char*, int, uint64_t);
+
+static uint16_t generateChecksumUnwrappedScalar(const char* data, int len,
+		uint64_t sum) {
+	return DataContainer::GenerateChecksumUnwrapped(data, len, sum);
+}
+
+static ChecksumKernel selectChecksumKernel() {
+#ifdef DATACONTAINER_HAVE_X86_KERNELS
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		return generateChecksumUnwrappedAVX2;
+	}
+	if (__builtin_cpu_supports("sse2")) {
+		return generateChecksumUnwrappedSSE2;
+	}
+#endif
+	return generateChecksumUnwrappedScalar;
+}
+
+uint16_t DataContainer::GenerateChecksumUnwrappedVectorized(const char* data,
+		int len, uint64_t sum) {
+	static const ChecksumKernel kernel = selectChecksumKernel();
+	return kernel(data, len, sum);
 }
 
 }
@@ -13,17 +13,27 @@
 #include <cstdint>
 
 #include "../options/Logging.h"
+#include "../utils/BufferPool.h"
 
 namespace na62 {
 struct DataContainer {
+	/*
+	 * Defines for which containers a checksum is generated at construction time (see checkValid())
+	 */
+	enum ChecksumPolicy {
+		CHECKSUM_OFF, CHECKSUM_SAMPLED, CHECKSUM_ALWAYS
+	};
+
 	char * data;
 	uint_fast16_t length;
 	bool ownerMayFreeData;
 
 	uint16_t checksum;
+	bool hasChecksum;
 
 	DataContainer() :
-			data(nullptr), length(0), ownerMayFreeData(false), checksum(0) {
+			data(nullptr), length(0), ownerMayFreeData(false), checksum(0), hasChecksum(
+					false) {
 	}
 
 	DataContainer(char* _data, uint_fast16_t _length, bool _ownerMayFreeData);
@@ -36,7 +46,8 @@ struct DataContainer {
 	 */
 	DataContainer(const DataContainer& other) :
 			data(other.data), length(std::move(other.length)), ownerMayFreeData(
-					other.ownerMayFreeData), checksum(other.checksum) {
+					other.ownerMayFreeData), checksum(other.checksum), hasChecksum(
+					other.hasChecksum) {
 	}
 
 	/**
@@ -44,7 +55,8 @@ struct DataContainer {
 	 */
 	DataContainer(const DataContainer&& other) :
 			data(other.data), length(other.length), ownerMayFreeData(
-					other.ownerMayFreeData), checksum(other.checksum) {
+					other.ownerMayFreeData), checksum(other.checksum), hasChecksum(
+					other.hasChecksum) {
 	}
 
 	/**
@@ -56,6 +68,7 @@ struct DataContainer {
 			length = other.length;
 			ownerMayFreeData = other.ownerMayFreeData;
 			checksum = other.checksum;
+			hasChecksum = other.hasChecksum;
 
 			other.data = nullptr;
 			other.length = 0;
@@ -72,12 +85,28 @@ struct DataContainer {
 			length = other.length;
 			ownerMayFreeData = other.ownerMayFreeData;
 			checksum = other.checksum;
+			hasChecksum = other.hasChecksum;
 		}
 		return *this;
 	}
 
+	/**
+	 * Returns false if the data has been modified since the construction of this container. Containers
+	 * without checksum (see setChecksumPolicy) are always valid
+	 */
 	bool checkValid();
 
+	/**
+	 * CHECKSUM_OFF: No checksum is generated
+	 * CHECKSUM_SAMPLED: Every <sampleRate>th container of each thread gets a checksum
+	 * CHECKSUM_ALWAYS: Every container gets a checksum (default)
+	 */
+	static void setChecksumPolicy(const ChecksumPolicy policy,
+			const uint sampleRate = 1) {
+		checksumPolicy_ = policy;
+		checksumSampleRate_ = sampleRate > 0 ? sampleRate : 1;
+	}
+
 	static inline u_int32_t Wrapsum(u_int32_t sum) {
 		sum = ~sum & 0xFFFF;
 		return (htons(sum));
@@ -85,9 +114,18 @@ struct DataContainer {
 
 	static inline uint16_t GenerateChecksum(const char* data, int len,
 			uint sum = 0) {
-		return Wrapsum(GenerateChecksumUnwrapped(data, len, sum));
+		return Wrapsum(GenerateChecksumUnwrappedVectorized(data, len, sum));
 	}
 
+	/**
+	 * Same result as GenerateChecksumUnwrapped but using AVX2 or SSE2 if supported by the CPU
+	 */
+	static uint16_t GenerateChecksumUnwrappedVectorized(const char* data,
+			int len, uint64_t sum = 0);
+
+	/**
+	 * Scalar reference implementation
+	 */
 	static inline uint16_t GenerateChecksumUnwrapped(const char* data, int len,
 			uint64_t sum = 0) {
 		int steps = len >> 2;
@@ -119,10 +157,15 @@ struct DataContainer {
 		//checkValid();
 		if (ownerMayFreeData) {
 			checksum = 0;
-			delete[] data;
+			hasChecksum = false;
+			BufferPool::returnBuffer(data);
 			data = nullptr;
 		}
 	}
+
+private:
+	static ChecksumPolicy checksumPolicy_;
+	static uint checksumSampleRate_;
 };
 
 }
@@ -0,0 +1,188 @@
+/*
+ * BoundedMPMCQueue.h
+ *
+ * Bounded lock-free multi producer multi consumer queue based on the array based queue by Dmitry Vyukov:
+ * http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+ *
+ * Every cell carries a sequence number telling producers and consumers whether the cell is free or
+ * filled for the current lap. Producers and consumers only contend on their own position counter.
+ *
+ * Contrary to the original implementation push() and pop() only fail if the queue is really full/empty.
+ * A cell claimed but not yet released by another thread makes them retry instead.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#pragma once
+#ifndef BOUNDEDMPMCQUEUE_H_
+#define BOUNDEDMPMCQUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <boost/noncopyable.hpp>
+
+namespace na62 {
+
+template<class T> class BoundedMPMCQueue: private boost::noncopyable {
+public:
+	/*
+	 * The capacity will be rounded up to the next power of two
+	 */
+	BoundedMPMCQueue(uint_fast32_t capacity) {
+		size_t size = 2;
+		while (size < capacity) {
+			size <<= 1;
+		}
+		mask_ = size - 1;
+		cells_ = new Cell[size];
+		for (size_t i = 0; i != size; i++) {
+			cells_[i].sequence.store(i, std::memory_order_relaxed);
+		}
+		enqueuePos_.store(0, std::memory_order_relaxed);
+		dequeuePos_.store(0, std::memory_order_relaxed);
+	}
+
+	~BoundedMPMCQueue() {
+		delete[] cells_;
+	}
+
+	/*
+	 * Appends the element to the queue. Returns false if the queue is full.
+	 * May be called by any number of threads concurrently.
+	 */
+	bool push(const T& element) {
+		Cell* cell;
+		size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+		for (;;) {
+			cell = &cells_[pos & mask_];
+			const size_t seq = cell->sequence.load(std::memory_order_acquire);
+			const intptr_t diff = (intptr_t) seq - (intptr_t) pos;
+			if (diff == 0) {
+				if (enqueuePos_.compare_exchange_weak(pos, pos + 1,
+						std::memory_order_relaxed)) {
+					break;
+				}
+			} else if (diff < 0) {
+				if ((intptr_t) (pos - dequeuePos_.load(std::memory_order_relaxed))
+						> (intptr_t) mask_) {
+					return false; // full
+				}
+				// A consumer still reads this cell
+				pos = enqueuePos_.load(std::memory_order_relaxed);
+			} else {
+				pos = enqueuePos_.load(std::memory_order_relaxed);
+			}
+		}
+		cell->data = element;
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	/*
+	 * Removes the oldest element from the queue. Returns false if the queue is empty.
+	 * May be called by any number of threads concurrently.
+	 */
+	bool pop(T& element) {
+		Cell* cell;
+		size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+		for (;;) {
+			cell = &cells_[pos & mask_];
+			const size_t seq = cell->sequence.load(std::memory_order_acquire);
+			const intptr_t diff = (intptr_t) seq - (intptr_t) (pos + 1);
+			if (diff == 0) {
+				if (dequeuePos_.compare_exchange_weak(pos, pos + 1,
+						std::memory_order_relaxed)) {
+					break;
+				}
+			} else if (diff < 0) {
+				if (enqueuePos_.load(std::memory_order_relaxed) == pos) {
+					return false; // empty
+				}
+				// A producer still writes this cell
+				pos = dequeuePos_.load(std::memory_order_relaxed);
+			} else {
+				pos = dequeuePos_.load(std::memory_order_relaxed);
+			}
+		}
+		element = cell->data;
+		cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+		return true;
+	}
+
+	/*
+	 * Removes up to <maxElements> of the oldest elements with a single update of the consumer position and
+	 * writes them to <elements>. Returns the number of removed elements (0 if the queue is empty).
+	 * May be called by any number of threads concurrently.
+	 */
+	uint_fast32_t popBatch(T* elements, const uint_fast32_t maxElements) {
+		size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+		size_t ready;
+		for (;;) {
+			/*
+			 * Count the consecutive cells already filled for the current lap
+			 */
+			for (ready = 0; ready != maxElements; ready++) {
+				const size_t seq = cells_[(pos + ready) & mask_].sequence.load(
+						std::memory_order_acquire);
+				if ((intptr_t) seq - (intptr_t) (pos + ready + 1) != 0) {
+					break;
+				}
+			}
+			if (ready == 0) {
+				const size_t seq = cells_[pos & mask_].sequence.load(std::memory_order_acquire);
+				if ((intptr_t) seq - (intptr_t) (pos + 1) < 0
+						&& enqueuePos_.load(std::memory_order_relaxed) == pos) {
+					return 0; // empty
+				}
+				// A producer still writes this cell or another consumer was faster
+				pos = dequeuePos_.load(std::memory_order_relaxed);
+				continue;
+			}
+			if (dequeuePos_.compare_exchange_weak(pos, pos + ready,
+					std::memory_order_relaxed)) {
+				break;
+			}
+		}
+		for (size_t i = 0; i != ready; i++) {
+			Cell* cell = &cells_[(pos + i) & mask_];
+			elements[i] = cell->data;
+			cell->sequence.store(pos + i + mask_ + 1, std::memory_order_release);
+		}
+		return ready;
+	}
+
+	uint_fast32_t size() const {
+		return mask_ + 1;
+	}
+
+	/*
+	 * Number of stored elements. This is only a snapshot as other threads may push or pop concurrently
+	 */
+	uint_fast32_t getCurrentLength() const {
+		const size_t enqueuePos = enqueuePos_.load(std::memory_order_relaxed);
+		const size_t dequeuePos = dequeuePos_.load(std::memory_order_relaxed);
+		return enqueuePos > dequeuePos ? enqueuePos - dequeuePos : 0;
+	}
+
+private:
+	struct Cell {
+		std::atomic<size_t> sequence;
+		T data;
+	};
+
+	/*
+	 * Keep the producer and consumer positions on separate cache lines
+	 */
+	char padding0_[64];
+	Cell* cells_;
+	size_t mask_;
+	char padding1_[64];
+	std::atomic<size_t> enqueuePos_;
+	char padding2_[64];
+	std::atomic<size_t> dequeuePos_;
+	char padding3_[64];
+};
+
+} /* namespace na62 */
+#endif /* BOUNDEDMPMCQUEUE_H_ */
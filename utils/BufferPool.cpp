@@ -0,0 +1,162 @@
+/*
+ * BufferPool.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "BufferPool.h"
+
+#include <sys/mman.h>
+#include <cstring>
+
+#include "../options/Logging.h"
+#include "NumaTopology.h"
+
+namespace na62 {
+
+std::vector<BufferPool::NodePool*> BufferPool::nodePools_;
+uint BufferPool::bufferSize_;
+uint BufferPool::bufferStride_;
+
+static const size_t HugepageSize = 2 * 1024 * 1024;
+
+void BufferPool::initialize(uint buffersPerNode, uint bufferSize,
+		bool useHugepages) {
+	NumaTopology::initialize();
+
+	bufferSize_ = bufferSize;
+	// Every buffer starts at a new cache line
+	bufferStride_ = (bufferSize + 63) & ~63;
+
+	for (uint node = 0; node != NumaTopology::getNumberOfNodes(); node++) {
+		NodePool* pool = new NodePool();
+		pool->regionSize = (size_t) buffersPerNode * bufferStride_;
+		pool->isHugepageBacked = false;
+
+		void* region = MAP_FAILED;
+		if (useHugepages) {
+			pool->regionSize = (pool->regionSize + HugepageSize - 1)
+					& ~(HugepageSize - 1);
+			region = mmap(nullptr, pool->regionSize, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			pool->isHugepageBacked = region != MAP_FAILED;
+			if (region == MAP_FAILED) {
+				LOG_WARNING("No hugepages available for the buffer pool of node " << node << ". Falling back to transparent hugepages");
+			}
+		}
+		if (region == MAP_FAILED) {
+			region = mmap(nullptr, pool->regionSize, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (region == MAP_FAILED) {
+				LOG_ERROR("Unable to allocate " << pool->regionSize << " B for the buffer pool of node " << node);
+				exit(1);
+			}
+			if (useHugepages) {
+				madvise(region, pool->regionSize, MADV_HUGEPAGE);
+			}
+		}
+		NumaTopology::bindMemory(region, pool->regionSize, node);
+
+		pool->regionBegin = static_cast<char*>(region);
+		pool->regionEnd = pool->regionBegin + (size_t) buffersPerNode * bufferStride_;
+		pool->freeBuffers = new BoundedMPMCQueue<char*>(buffersPerNode);
+		pool->hits = 0;
+		pool->misses = 0;
+		pool->buffersInUse = 0;
+		pool->highWatermark = 0;
+
+		/*
+		 * Touch all pages from the node itself so that no page fault happens while receiving
+		 */
+		NumaTopology::runOnNode(node, [pool]() {
+			memset(pool->regionBegin, 0, pool->regionSize);
+		});
+
+		for (char* buffer = pool->regionBegin; buffer != pool->regionEnd;
+				buffer += bufferStride_) {
+			pool->freeBuffers->push(buffer);
+		}
+		nodePools_.push_back(pool);
+	}
+
+	LOG_INFO("Initialized buffer pool with " << buffersPerNode << " buffers of " << bufferSize << " B on each of " << nodePools_.size() << " NUMA node(s)");
+}
+
+char* BufferPool::getBuffer() {
+	if (!isActive()) {
+		return new char[bufferSize_];
+	}
+	return getBuffer(NumaTopology::getCurrentNode());
+}
+
+char* BufferPool::getBuffer(const uint node) {
+	if (!isActive()) {
+		return new char[bufferSize_];
+	}
+	NodePool* pool = nodePools_[node < nodePools_.size() ? node : 0];
+
+	char* buffer;
+	if (!pool->freeBuffers->pop(buffer)) {
+		pool->misses.fetch_add(1, std::memory_order_relaxed);
+		return new char[bufferSize_];
+	}
+	pool->hits.fetch_add(1, std::memory_order_relaxed);
+
+	const uint64_t inUse = pool->buffersInUse.fetch_add(1,
+			std::memory_order_relaxed) + 1;
+	uint64_t highWatermark = pool->highWatermark.load(
+			std::memory_order_relaxed);
+	while (inUse > highWatermark
+			&& !pool->highWatermark.compare_exchange_weak(highWatermark, inUse,
+					std::memory_order_relaxed)) {
+	}
+	return buffer;
+}
+
+void BufferPool::returnBufferToPool(char* buffer) {
+	for (NodePool* pool : nodePools_) {
+		if (buffer >= pool->regionBegin && buffer < pool->regionEnd) {
+			pool->buffersInUse.fetch_sub(1, std::memory_order_relaxed);
+			pool->freeBuffers->push(buffer);
+			return;
+		}
+	}
+	// Allocated during a pool miss
+	delete[] buffer;
+}
+
+uint64_t BufferPool::getPoolHits() {
+	uint64_t sum = 0;
+	for (NodePool* pool : nodePools_) {
+		sum += pool->hits;
+	}
+	return sum;
+}
+
+uint64_t BufferPool::getPoolMisses() {
+	uint64_t sum = 0;
+	for (NodePool* pool : nodePools_) {
+		sum += pool->misses;
+	}
+	return sum;
+}
+
+uint64_t BufferPool::getHighWatermark(const uint node) {
+	return nodePools_[node]->highWatermark;
+}
+
+uint64_t BufferPool::getHighWatermark() {
+	uint64_t sum = 0;
+	for (NodePool* pool : nodePools_) {
+		sum += pool->highWatermark;
+	}
+	return sum;
+}
+
+void BufferPool::resetHighWatermarks() {
+	for (NodePool* pool : nodePools_) {
+		pool->highWatermark = pool->buffersInUse.load();
+	}
+}
+
+} /* namespace na62 */
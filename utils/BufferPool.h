@@ -0,0 +1,109 @@
+/*
+ * BufferPool.h
+ *
+ * Pool of fixed size receive buffers. Every NUMA node owns one memory region that is cut into buffers
+ * which are handed out by getBuffer() and given back by returnBuffer() (called by DataContainer::free()).
+ * This way no malloc/free is needed for every received frame.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#pragma once
+#ifndef BUFFERPOOL_H_
+#define BUFFERPOOL_H_
+
+#include <sys/types.h>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "BoundedMPMCQueue.h"
+
+namespace na62 {
+
+class BufferPool {
+public:
+	/**
+	 * Allocates <buffersPerNode> buffers of <bufferSize> bytes (typically MTU) on every NUMA node.
+	 * If <useHugepages> is set the regions are backed by hugepages if available
+	 */
+	static void initialize(uint buffersPerNode, uint bufferSize,
+			bool useHugepages = false);
+
+	static inline bool isActive() {
+		return !nodePools_.empty();
+	}
+
+	static inline uint getBufferSize() {
+		return bufferSize_;
+	}
+
+	/**
+	 * Returns a buffer of getBufferSize() bytes preferably from the NUMA node the calling thread is running on.
+	 * If the pool is empty or not initialized a new buffer is allocated on the heap (pool miss)
+	 */
+	static char* getBuffer();
+	static char* getBuffer(const uint node);
+
+	/**
+	 * Puts the buffer back into the pool of the node owning it. Buffers not allocated by the pool are deleted
+	 */
+	static inline void returnBuffer(char* buffer) {
+		if (!isActive()) {
+			delete[] buffer;
+			return;
+		}
+		returnBufferToPool(buffer);
+	}
+
+	/*
+	 * Number of getBuffer() calls served by the pool
+	 */
+	static uint64_t getPoolHits();
+
+	/*
+	 * Number of getBuffer() calls that had to allocate a new buffer as the pool was empty
+	 */
+	static uint64_t getPoolMisses();
+
+	/*
+	 * Maximum number of pool buffers in use at the same time on the given node since the last reset
+	 */
+	static uint64_t getHighWatermark(const uint node);
+
+	/*
+	 * Sum of the high watermarks of all nodes
+	 */
+	static uint64_t getHighWatermark();
+
+	/*
+	 * Sets the high watermarks to the number of buffers currently in use. Call this at every burst change
+	 * to get the watermark per burst
+	 */
+	static void resetHighWatermarks();
+
+private:
+	struct NodePool {
+		char* regionBegin;
+		char* regionEnd;
+		size_t regionSize;
+		bool isHugepageBacked;
+		BoundedMPMCQueue<char*>* freeBuffers;
+
+		std::atomic<uint64_t> hits;
+		std::atomic<uint64_t> misses;
+		std::atomic<uint64_t> buffersInUse;
+		std::atomic<uint64_t> highWatermark;
+		char padding[64];
+	};
+
+	static void returnBufferToPool(char* buffer);
+
+	static std::vector<NodePool*> nodePools_;
+	static uint bufferSize_;
+	static uint bufferStride_;
+};
+
+} /* namespace na62 */
+
+#endif /* BUFFERPOOL_H_ */
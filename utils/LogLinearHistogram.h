@@ -0,0 +1,154 @@
+/*
+ * LogLinearHistogram.h
+ *
+ * Histogram with logarithmically growing bucket widths: every power of two is split into
+ * 2^SubBucketBits linear buckets, so the relative error of a recorded value is below 1/2^SubBucketBits
+ * over the whole 64 bit range. Values are recorded with a single relaxed atomic increment and no
+ * allocation so the histogram may be filled by any number of threads.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#pragma once
+#ifndef LOGLINEARHISTOGRAM_H_
+#define LOGLINEARHISTOGRAM_H_
+
+#include <atomic>
+#include <cstdint>
+#include <boost/noncopyable.hpp>
+
+namespace na62 {
+
+class LogLinearHistogram: private boost::noncopyable {
+public:
+	static const uint_fast32_t SubBucketBits = 4;
+	static const uint_fast32_t SubBuckets = 1 << SubBucketBits;
+	static const uint_fast32_t NumberOfBuckets = (64 - SubBucketBits + 1) * SubBuckets;
+
+	LogLinearHistogram() {
+		reset();
+	}
+
+	static inline uint_fast32_t getBucketIndex(const uint64_t value) {
+		if (value < SubBuckets) {
+			return value;
+		}
+		const uint_fast32_t shift = 63 - __builtin_clzll(value) - SubBucketBits;
+		return (shift + 1) * SubBuckets + ((value >> shift) & (SubBuckets - 1));
+	}
+
+	/*
+	 * Smallest value stored in the given bucket
+	 */
+	static inline uint64_t getBucketLowerBound(const uint_fast32_t bucket) {
+		if (bucket < SubBuckets) {
+			return bucket;
+		}
+		const uint_fast32_t shift = bucket / SubBuckets - 1;
+		return (uint64_t) (SubBuckets + bucket % SubBuckets) << shift;
+	}
+
+	/*
+	 * Largest value stored in the given bucket
+	 */
+	static inline uint64_t getBucketUpperBound(const uint_fast32_t bucket) {
+		if (bucket == NumberOfBuckets - 1) {
+			return UINT64_MAX;
+		}
+		return getBucketLowerBound(bucket + 1) - 1;
+	}
+
+	inline void record(const uint64_t value) {
+		buckets_[getBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+		sum_.fetch_add(value, std::memory_order_relaxed);
+	}
+
+	/*
+	 * Same as record() without locked instructions. Only valid if no other thread records values concurrently
+	 */
+	inline void recordSingleWriter(const uint64_t value) {
+		std::atomic<uint64_t>& bucket = buckets_[getBucketIndex(value)];
+		bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		sum_.store(sum_.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+	}
+
+	inline uint64_t getBucketCount(const uint_fast32_t bucket) const {
+		return buckets_[bucket].load(std::memory_order_relaxed);
+	}
+
+	uint64_t getCount() const {
+		uint64_t count = 0;
+		for (uint_fast32_t bucket = 0; bucket != NumberOfBuckets; bucket++) {
+			count += getBucketCount(bucket);
+		}
+		return count;
+	}
+
+	uint64_t getSum() const {
+		return sum_.load(std::memory_order_relaxed);
+	}
+
+	/*
+	 * Returns the upper bound of the bucket containing the <percentile> (0-100) of all recorded values
+	 * or 0 if nothing has been recorded
+	 */
+	uint64_t getPercentile(const double percentile) const {
+		const uint64_t count = getCount();
+		if (count == 0) {
+			return 0;
+		}
+		uint64_t rank = (uint64_t) (percentile / 100. * count + 0.5);
+		if (rank == 0) {
+			rank = 1;
+		}
+		uint64_t seen = 0;
+		for (uint_fast32_t bucket = 0; bucket != NumberOfBuckets; bucket++) {
+			seen += getBucketCount(bucket);
+			if (seen >= rank) {
+				return getBucketUpperBound(bucket);
+			}
+		}
+		return getBucketUpperBound(NumberOfBuckets - 1);
+	}
+
+	/*
+	 * Adds all counts of this histogram to <other>
+	 */
+	void addTo(LogLinearHistogram& other) const {
+		for (uint_fast32_t bucket = 0; bucket != NumberOfBuckets; bucket++) {
+			const uint64_t count = getBucketCount(bucket);
+			if (count != 0) {
+				other.buckets_[bucket].fetch_add(count, std::memory_order_relaxed);
+			}
+		}
+		other.sum_.fetch_add(getSum(), std::memory_order_relaxed);
+	}
+
+	/*
+	 * Removes all counts of <other> from this histogram. <other> must be an earlier snapshot of this histogram
+	 */
+	void subtract(const LogLinearHistogram& other) {
+		for (uint_fast32_t bucket = 0; bucket != NumberOfBuckets; bucket++) {
+			const uint64_t count = other.getBucketCount(bucket);
+			if (count != 0) {
+				buckets_[bucket].fetch_sub(count, std::memory_order_relaxed);
+			}
+		}
+		sum_.fetch_sub(other.getSum(), std::memory_order_relaxed);
+	}
+
+	void reset() {
+		for (uint_fast32_t bucket = 0; bucket != NumberOfBuckets; bucket++) {
+			buckets_[bucket].store(0, std::memory_order_relaxed);
+		}
+		sum_.store(0, std::memory_order_relaxed);
+	}
+
+private:
+	std::atomic<uint64_t> buckets_[NumberOfBuckets];
+	std::atomic<uint64_t> sum_;
+};
+
+} /* namespace na62 */
+
+#endif /* LOGLINEARHISTOGRAM_H_ */
@@ -0,0 +1,113 @@
+/*
+ * NumaTopology.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "NumaTopology.h"
+
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "../options/Logging.h"
+#include "Utils.h"
+
+namespace na62 {
+
+std::vector<uint> NumaTopology::nodeByCPU_;
+std::vector<std::vector<uint> > NumaTopology::CPUsByNode_;
+
+/*
+ * Parses cpu lists like "0-7,16-23"
+ */
+static std::vector<uint> parseCPUList(const std::string& cpuList) {
+	std::vector<uint> cpus;
+	std::vector<std::string> ranges;
+	boost::split(ranges, cpuList, boost::is_any_of(","));
+	for (std::string range : ranges) {
+		boost::trim(range);
+		if (range.empty()) {
+			continue;
+		}
+		std::vector<std::string> minMax;
+		boost::split(minMax, range, boost::is_any_of("-"));
+		const uint min = Utils::ToUInt(minMax[0]);
+		const uint max = minMax.size() == 2 ? Utils::ToUInt(minMax[1]) : min;
+		for (uint cpu = min; cpu <= max; cpu++) {
+			cpus.push_back(cpu);
+		}
+	}
+	return cpus;
+}
+
+void NumaTopology::initialize() {
+	if (!CPUsByNode_.empty()) {
+		return;
+	}
+
+	for (uint node = 0;; node++) {
+		const std::string cpuListFile = "/sys/devices/system/node/node"
+				+ std::to_string(node) + "/cpulist";
+		if (!boost::filesystem::exists(cpuListFile)) {
+			break;
+		}
+		std::ifstream file(cpuListFile);
+		std::string cpuList;
+		std::getline(file, cpuList);
+		CPUsByNode_.push_back(parseCPUList(cpuList));
+	}
+
+	if (CPUsByNode_.empty()) {
+		std::vector<uint> allCPUs;
+		for (uint cpu = 0; cpu != std::thread::hardware_concurrency(); cpu++) {
+			allCPUs.push_back(cpu);
+		}
+		CPUsByNode_.push_back(allCPUs);
+	}
+
+	for (uint node = 0; node != CPUsByNode_.size(); node++) {
+		for (uint cpu : CPUsByNode_[node]) {
+			if (cpu >= nodeByCPU_.size()) {
+				nodeByCPU_.resize(cpu + 1, 0);
+			}
+			nodeByCPU_[cpu] = node;
+		}
+	}
+
+	LOG_INFO("Found " << CPUsByNode_.size() << " NUMA node(s)");
+}
+
+void NumaTopology::bindMemory(void* address, const size_t length,
+		const uint node) {
+	if (getNumberOfNodes() < 2 || node >= sizeof(unsigned long) * 8) {
+		return;
+	}
+	unsigned long nodeMask = 1UL << node;
+	if (syscall(SYS_mbind, address, length, MPOL_PREFERRED, &nodeMask,
+			sizeof(nodeMask) * 8, 0) != 0) {
+		LOG_WARNING("Unable to bind memory to NUMA node " << node);
+	}
+}
+
+void NumaTopology::runOnNode(const uint node,
+		std::function<void()> function) {
+	std::thread thread([node, &function]() {
+		cpu_set_t cpuSet;
+		CPU_ZERO(&cpuSet);
+		for (uint cpu : getCPUsOfNode(node)) {
+			CPU_SET(cpu, &cpuSet);
+		}
+		pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet);
+		function();
+	});
+	thread.join();
+}
+
+} /* namespace na62 */
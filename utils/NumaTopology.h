@@ -0,0 +1,74 @@
+/*
+ * NumaTopology.h
+ *
+ * Static view of the NUMA nodes and their CPUs as exported by /sys/devices/system/node
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#pragma once
+#ifndef NUMATOPOLOGY_H_
+#define NUMATOPOLOGY_H_
+
+#include <sched.h>
+#include <sys/types.h>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace na62 {
+
+class NumaTopology {
+public:
+	/**
+	 * Reads the NUMA layout of this machine. If the system does not export any NUMA information
+	 * all CPUs are assigned to node 0. Calling this method more than once has no effect.
+	 */
+	static void initialize();
+
+	static inline uint getNumberOfNodes() {
+		return CPUsByNode_.size();
+	}
+
+	static inline uint getNodeOfCPU(const uint cpu) {
+		if (cpu >= nodeByCPU_.size()) {
+			return 0;
+		}
+		return nodeByCPU_[cpu];
+	}
+
+	/**
+	 * Returns the node of the CPU the calling thread is currently running on
+	 */
+	static inline uint getCurrentNode() {
+		const int cpu = sched_getcpu();
+		if (cpu < 0) {
+			return 0;
+		}
+		return getNodeOfCPU(cpu);
+	}
+
+	static inline const std::vector<uint>& getCPUsOfNode(const uint node) {
+		return CPUsByNode_[node];
+	}
+
+	/**
+	 * Asks the kernel to allocate the pages of the given memory region on <node>. This only affects pages
+	 * not yet touched and silently does nothing if the kernel does not support it
+	 */
+	static void bindMemory(void* address, const size_t length, const uint node);
+
+	/**
+	 * Executes <function> in a new thread bound to the CPUs of <node> and waits for it to finish.
+	 * Memory touched first within <function> will therefore be allocated on <node>.
+	 */
+	static void runOnNode(const uint node, std::function<void()> function);
+
+private:
+	static std::vector<uint> nodeByCPU_;
+	static std::vector<std::vector<uint> > CPUsByNode_;
+};
+
+} /* namespace na62 */
+
+#endif /* NUMATOPOLOGY_H_ */
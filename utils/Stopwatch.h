@@ -81,7 +81,7 @@ public:
 		/*
 		 * Heat up CPU for turbo mode
 		 */
-		int sum;
+		uint64_t sum = 0;
 		for (int i = 0; i < 1000000; i++) {
 			sum += rand();
 		}